@@ -2,8 +2,10 @@
 
 #include "MobAI.hpp"
 #include "NPCManager.hpp"
+#include "PlayerManager.hpp"
 
 #include <assert.h>
+#include <unordered_map>
 
 using namespace Chunking;
 
@@ -12,7 +14,117 @@ using namespace Chunking;
  */
 const ChunkPos Chunking::INVALID_CHUNK = {};
 
-std::map<ChunkPos, Chunk*> Chunking::chunks;
+/*
+ * Open-addressing (linear probing) hash table of the chunks in one instance,
+ * keyed by their packed X and Y coordinates.
+ */
+class ChunkGrid {
+private:
+    struct Slot {
+        uint64_t key;
+        Chunk *chunk; // null if the slot is empty
+    };
+
+    std::vector<Slot> slots;
+    size_t count = 0;
+
+    static uint64_t pack(int x, int y) {
+        return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+    }
+
+    size_t home(uint64_t key) const {
+        uint64_t h = key * 0x9E3779B97F4A7C15ULL;
+        return (h ^ (h >> 32)) & (slots.size() - 1);
+    }
+
+    void grow() {
+        std::vector<Slot> old(slots.size() == 0 ? 64 : slots.size() * 2, Slot{0, nullptr});
+        old.swap(slots);
+
+        for (Slot& slot : old) {
+            if (slot.chunk == nullptr)
+                continue;
+
+            size_t i = home(slot.key);
+            while (slots[i].chunk != nullptr)
+                i = (i + 1) & (slots.size() - 1);
+            slots[i] = slot;
+        }
+    }
+
+public:
+    size_t size() const { return count; }
+
+    Chunk *find(int x, int y) const {
+        if (count == 0)
+            return nullptr;
+
+        uint64_t key = pack(x, y);
+        for (size_t i = home(key); slots[i].chunk != nullptr; i = (i + 1) & (slots.size() - 1))
+            if (slots[i].key == key)
+                return slots[i].chunk;
+
+        return nullptr;
+    }
+
+    void insert(int x, int y, Chunk *chunk) {
+        // keep the load factor at or below 1/2
+        if ((count + 1) * 2 > slots.size())
+            grow();
+
+        uint64_t key = pack(x, y);
+        size_t i = home(key);
+        while (slots[i].chunk != nullptr)
+            i = (i + 1) & (slots.size() - 1);
+
+        slots[i] = {key, chunk};
+        count++;
+    }
+
+    void erase(int x, int y) {
+        if (count == 0)
+            return;
+
+        size_t mask = slots.size() - 1;
+        uint64_t key = pack(x, y);
+        size_t i = home(key);
+        while (slots[i].chunk != nullptr && slots[i].key != key)
+            i = (i + 1) & mask;
+
+        if (slots[i].chunk == nullptr)
+            return; // not present
+
+        /*
+         * Shift back any later entries of the same probe run that would
+         * no longer be reachable through the hole, instead of leaving a
+         * tombstone behind.
+         */
+        for (size_t j = (i + 1) & mask; slots[j].chunk != nullptr; j = (j + 1) & mask) {
+            size_t k = home(slots[j].key);
+            if (((j - k) & mask) >= ((j - i) & mask)) {
+                slots[i] = slots[j];
+                i = j;
+            }
+        }
+
+        slots[i].chunk = nullptr;
+        count--;
+    }
+
+    template<class F>
+    void forEach(F func) const {
+        for (const Slot& slot : slots)
+            if (slot.chunk != nullptr)
+                func(slot.chunk);
+    }
+};
+
+// one grid per instance; a grid is dropped as soon as its last chunk is
+static std::unordered_map<uint64_t, ChunkGrid> grids;
+
+static inline int neighborIndex(int dx, int dy) {
+    return (dx + 1) * 3 + (dy + 1);
+}
 
 static void newChunk(ChunkPos pos) {
     if (chunkExists(pos)) {
@@ -20,123 +132,319 @@ static void newChunk(ChunkPos pos) {
         return;
     }
 
+    int x, y;
+    uint64_t inst;
+    std::tie(x, y, inst) = pos;
+
+    ChunkGrid& grid = grids[inst];
     Chunk *chunk = new Chunk();
-    chunks[pos] = chunk;
+    chunk->pos = pos;
+    grid.insert(x, y, chunk);
+
+    // link the chunk up with its existing neighbours, in both directions
+    for (int dx = -1; dx < 2; dx++) {
+        for (int dy = -1; dy < 2; dy++) {
+            Chunk *other = (dx == 0 && dy == 0) ? chunk : grid.find(x + dx, y + dy);
+            chunk->neighbors[neighborIndex(dx, dy)] = other;
+            if (other != nullptr)
+                other->neighbors[neighborIndex(-dx, -dy)] = chunk;
+        }
+    }
 
     // add the chunk to the cache of all players and NPCs in the surrounding chunks
-    std::set<Chunk*> surroundings = getViewableChunks(pos);
-    for (Chunk* c : surroundings)
-        for (const EntityRef ref : c->entities)
-            ref.getEntity()->viewableChunks.insert(chunk);
+    for (Chunk* c : getViewableChunks(pos)) {
+        for (const ChunkEntity& other : c->players)
+            other.ent->viewableChunks.insert(chunk);
+        for (const ChunkEntity& other : c->npcs)
+            other.ent->viewableChunks.insert(chunk);
+    }
 }
 
 static void deleteChunk(ChunkPos pos) {
-    if (!chunkExists(pos)) {
+    Chunk* chunk = getChunk(pos);
+    if (chunk == nullptr) {
         std::cout << "[WARN] Tried to delete a chunk that doesn't exist" << std::endl;
         return;
     }
 
-    Chunk* chunk = chunks[pos];
-
     // remove the chunk from the cache of all players and NPCs in the surrounding chunks
-    std::set<Chunk*> surroundings = getViewableChunks(pos);
-    for(Chunk* c : surroundings)
-        for (const EntityRef ref : c->entities)
-            ref.getEntity()->viewableChunks.erase(chunk);
+    for (Chunk* c : getViewableChunks(pos)) {
+        for (const ChunkEntity& other : c->players)
+            other.ent->viewableChunks.erase(chunk);
+        for (const ChunkEntity& other : c->npcs)
+            other.ent->viewableChunks.erase(chunk);
+    }
+
+    // unlink it from its neighbours
+    for (int dx = -1; dx < 2; dx++) {
+        for (int dy = -1; dy < 2; dy++) {
+            Chunk *other = chunk->neighbors[neighborIndex(dx, dy)];
+            if (other != nullptr)
+                other->neighbors[neighborIndex(-dx, -dy)] = nullptr;
+        }
+    }
+
+    int x, y;
+    uint64_t inst;
+    std::tie(x, y, inst) = pos;
+
+    auto it = grids.find(inst);
+    it->second.erase(x, y); // remove from grid
+    if (it->second.size() == 0)
+        grids.erase(it);
 
-    chunks.erase(pos); // remove from map
     delete chunk; // free from memory
 }
 
 void Chunking::trackEntity(ChunkPos chunkPos, const EntityRef ref) {
-    if (!chunkExists(chunkPos))
+    Chunk* chunk = getChunk(chunkPos);
+    if (chunk == nullptr)
         return; // shouldn't happen
 
-    chunks[chunkPos]->entities.insert(ref);
+    std::vector<ChunkEntity>& list = ref.kind == EntityKind::PLAYER ? chunk->players : chunk->npcs;
+    Entity *ent = ref.getEntity();
 
+    ent->chunkIndex = list.size();
+    list.push_back({ref, ent});
     if (ref.kind == EntityKind::PLAYER)
-        chunks[chunkPos]->nplayers++;
+        chunk->playerPos.push_back({ent->x, ent->y, ent->z});
+
+    // makes sure newly placed combat NPCs get stepped, if they need to be
+    if (ref.kind == EntityKind::COMBAT_NPC || ref.kind == EntityKind::MOB)
+        NPCManager::wakeNPC((CombatNPC*)ent);
 }
 
 void Chunking::untrackEntity(ChunkPos chunkPos, const EntityRef ref) {
-    if (!chunkExists(chunkPos))
+    Chunk* chunk = getChunk(chunkPos);
+    if (chunk == nullptr)
         return; // do nothing if chunk doesn't even exist
 
-    Chunk* chunk = chunks[chunkPos];
+    std::vector<ChunkEntity>& list = ref.kind == EntityKind::PLAYER ? chunk->players : chunk->npcs;
+    Entity *ent = ref.getEntity();
 
-    chunk->entities.erase(ref); // gone
+    int i = ent->chunkIndex;
+    if (i < 0 || i >= (int)list.size() || list[i].ref != ref)
+        return; // not tracked in this chunk
 
-    if (ref.kind == EntityKind::PLAYER)
-        chunks[chunkPos]->nplayers--;
-    assert(chunks[chunkPos]->nplayers >= 0);
+    // swap with the last entry so nothing has to be shifted
+    list[i] = list.back();
+    list[i].ent->chunkIndex = i;
+    list.pop_back();
+    ent->chunkIndex = -1; // gone
+
+    if (ref.kind == EntityKind::PLAYER) {
+        chunk->playerPos[i] = chunk->playerPos.back();
+        chunk->playerPos.pop_back();
+    }
 
     // if chunk is completely empty, free it
-    if (chunk->entities.size() == 0)
+    if (chunk->empty())
         deleteChunk(chunkPos);
 }
 
-void Chunking::addEntityToChunks(std::set<Chunk*> chnks, const EntityRef ref) {
+// for players moving around within the same chunk
+void Chunking::updatePlayerPos(const EntityRef ref) {
+    Entity *ent = ref.getEntity();
+    Chunk *chunk = getChunk(ent->chunkPos);
+    if (chunk == nullptr || ent->chunkIndex < 0)
+        return;
+
+    chunk->playerPos[ent->chunkIndex] = {ent->x, ent->y, ent->z};
+}
+
+/*
+ * Collects the trailing structs of one of the variadic AROUND or AROUND_DEL
+ * packets bound for a single player, sending a packet off whenever the next
+ * struct wouldn't fit anymore.
+ */
+class AroundBatch {
+private:
+    CNSocket *sock;
+    uint32_t type;
+    const PacketDesc& desc;
+    int32_t count = 0;
+    int32_t capacity;
+    uint8_t buf[CN_PACKET_BUFFER_SIZE];
+
+public:
+    AroundBatch(CNSocket *s, uint32_t t) : sock(s), type(t), desc(*Packets::getDesc(t)) {
+        assert(desc.variadic);
+        capacity = (CN_PACKET_BUFFER_SIZE - 8 - desc.size) / desc.trailerSize;
+        memset(buf, 0, desc.size);
+    }
+
+    // for header fields other than the count
+    template<class Pkt>
+    Pkt *header() { return (Pkt*)buf; }
+
+    template<class T>
+    void add(const T& item) {
+        assert(sizeof(T) == desc.trailerSize);
+
+        if (count == capacity)
+            flush();
+
+        memcpy(buf + desc.size + count * sizeof(T), &item, sizeof(T));
+        count++;
+    }
+
+    void flush() {
+        if (count == 0)
+            return;
+
+        memcpy(buf + desc.cntMembOfs, &count, sizeof(int32_t));
+        sock->sendPacket(buf, type, desc.size + count * desc.trailerSize);
+        count = 0;
+    }
+};
+
+/*
+ * Everything entering or leaving a single player's view during one chunk
+ * update, sent as AROUND/AROUND_DEL packets instead of an ENTER or EXIT
+ * packet for every entity. Remember to flush() it.
+ */
+class ViewBatch {
+private:
+    AroundBatch pcs, npcs, shinies, buses;
+
+public:
+    ViewBatch(CNSocket *sock, bool entering) :
+        pcs(sock, entering ? P_FE2CL_PC_AROUND : P_FE2CL_AROUND_DEL_PC),
+        npcs(sock, entering ? P_FE2CL_NPC_AROUND : P_FE2CL_AROUND_DEL_NPC),
+        shinies(sock, entering ? P_FE2CL_SHINY_AROUND : P_FE2CL_AROUND_DEL_SHINY),
+        buses(sock, entering ? P_FE2CL_TRANSPORTATION_AROUND : P_FE2CL_AROUND_DEL_TRANSPORTATION) {
+        if (!entering)
+            buses.header<sP_FE2CL_AROUND_DEL_TRANSPORTATION>()->eTT = 3;
+    }
+
+    void enter(const ChunkEntity& other) {
+        switch (other.ref.kind) {
+        case EntityKind::PLAYER:
+            pcs.add(((Player*)other.ent)->getAppearanceData());
+            break;
+        case EntityKind::EGG:
+            shinies.add(((Egg*)other.ent)->getShinyAppearanceData());
+            break;
+        case EntityKind::BUS:
+            buses.add(((Bus*)other.ent)->getTransportationAppearanceData());
+            break;
+        default:
+            npcs.add(((BaseNPC*)other.ent)->getAppearanceData());
+            break;
+        }
+    }
+
+    void exit(const ChunkEntity& other) {
+        switch (other.ref.kind) {
+        case EntityKind::PLAYER:
+            pcs.add((int32_t)((Player*)other.ent)->iID);
+            break;
+        case EntityKind::EGG:
+            shinies.add((int32_t)((Egg*)other.ent)->id);
+            break;
+        case EntityKind::BUS:
+            buses.add((int32_t)((Bus*)other.ent)->id);
+            break;
+        default:
+            npcs.add((int32_t)((BaseNPC*)other.ent)->id);
+            break;
+        }
+    }
+
+    void flush() {
+        pcs.flush();
+        npcs.flush();
+        shinies.flush();
+        buses.flush();
+    }
+};
+
+void Chunking::addEntityToChunks(const ChunkSet& chnks, const EntityRef ref) {
     Entity *ent = ref.getEntity();
     bool alive = ent->isExtant();
 
-    // TODO: maybe optimize this, potentially using AROUND packets?
     for (Chunk *chunk : chnks) {
-        for (const EntityRef otherRef : chunk->entities) {
+        for (const ChunkEntity& other : chunk->players) {
             // skip oneself
-            if (ref == otherRef)
+            if (ref == other.ref)
                 continue;
 
-            Entity *other = otherRef.getEntity();
-
             // notify all visible players of the existence of this Entity
-            if (alive && otherRef.kind == EntityKind::PLAYER) {
-                ent->enterIntoViewOf(otherRef.sock);
-            }
-
-            // notify this *player* of the existence of all visible Entities
-            if (ref.kind == EntityKind::PLAYER && other->isExtant()) {
-                other->enterIntoViewOf(ref.sock);
-            }
+            if (alive)
+                ent->enterIntoViewOf(other.ref.sock);
 
             // for mobs, increment playersInView
-            if (ref.kind == EntityKind::MOB && otherRef.kind == EntityKind::PLAYER)
+            if (ref.kind == EntityKind::MOB)
                 ((Mob*)ent)->playersInView++;
-            if (otherRef.kind == EntityKind::MOB && ref.kind == EntityKind::PLAYER)
-                ((Mob*)other)->playersInView++;
         }
     }
+
+    if (ref.kind == EntityKind::MOB)
+        NPCManager::wakeNPC((Mob*)ent);
+
+    // NPCs don't need to know about anything else
+    if (ref.kind != EntityKind::PLAYER)
+        return;
+
+    // notify this *player* of the existence of all visible Entities
+    ViewBatch batch(ref.sock, true);
+    for (Chunk *chunk : chnks) {
+        for (const ChunkEntity& other : chunk->players)
+            if (ref != other.ref && other.ent->isExtant())
+                batch.enter(other);
+
+        for (const ChunkEntity& other : chunk->npcs) {
+            if (other.ent->isExtant())
+                batch.enter(other);
+
+            // wake up mobs that just got their first player in view
+            if (other.ref.kind == EntityKind::MOB && ++((Mob*)other.ent)->playersInView == 1)
+                NPCManager::wakeNPC((Mob*)other.ent);
+        }
+    }
+    batch.flush();
 }
 
-void Chunking::removeEntityFromChunks(std::set<Chunk*> chnks, const EntityRef ref) {
+void Chunking::removeEntityFromChunks(const ChunkSet& chnks, const EntityRef ref) {
     Entity *ent = ref.getEntity();
     bool alive = ent->isExtant();
 
-    // TODO: same as above
     for (Chunk *chunk : chnks) {
-        for (const EntityRef otherRef : chunk->entities) {
+        for (const ChunkEntity& other : chunk->players) {
             // skip oneself
-            if (ref == otherRef)
+            if (ref == other.ref)
                 continue;
 
-            Entity *other = otherRef.getEntity();
-
             // notify all visible players of the departure of this Entity
-            if (alive && otherRef.kind == EntityKind::PLAYER) {
-                ent->disappearFromViewOf(otherRef.sock);
-            }
-
-            // notify this *player* of the departure of all visible Entities
-            if (ref.kind == EntityKind::PLAYER && other->isExtant()) {
-                other->disappearFromViewOf(ref.sock);
-            }
+            if (alive)
+                ent->disappearFromViewOf(other.ref.sock);
 
             // for mobs, decrement playersInView
-            if (ref.kind == EntityKind::MOB && otherRef.kind == EntityKind::PLAYER)
+            if (ref.kind == EntityKind::MOB)
                 ((Mob*)ent)->playersInView--;
-            if (otherRef.kind == EntityKind::MOB && ref.kind == EntityKind::PLAYER)
-                ((Mob*)other)->playersInView--;
         }
     }
+
+    if (ref.kind != EntityKind::PLAYER)
+        return;
+
+    // notify this *player* of the departure of all visible Entities
+    ViewBatch batch(ref.sock, false);
+    for (Chunk *chunk : chnks) {
+        for (const ChunkEntity& other : chunk->players)
+            if (ref != other.ref && other.ent->isExtant())
+                batch.exit(other);
+
+        for (const ChunkEntity& other : chunk->npcs) {
+            if (other.ent->isExtant())
+                batch.exit(other);
+
+            // mobs left without players are dropped by the next NPC step
+            if (other.ref.kind == EntityKind::MOB)
+                ((Mob*)other.ent)->playersInView--;
+        }
+    }
+    batch.flush();
 }
 
 static void emptyChunk(ChunkPos chunkPos) {
@@ -145,27 +453,60 @@ static void emptyChunk(ChunkPos chunkPos) {
         return; // chunk doesn't exist, we don't need to do anything
     }
 
-    Chunk* chunk = chunks[chunkPos];
+    Chunk* chunk = getChunk(chunkPos);
 
-    if (chunk->nplayers > 0) {
+    if (!chunk->players.empty()) {
         std::cout << "[WARN] Tried to empty chunk that still had players\n";
         return; // chunk doesn't exist, we don't need to do anything
     }
 
     // unspawn all of the mobs/npcs
-    std::set refs(chunk->entities);
-    for (const EntityRef ref : refs) {
-        if (ref.kind == EntityKind::PLAYER)
-            assert(0);
-
+    std::vector<ChunkEntity> npcs(chunk->npcs);
+    for (const ChunkEntity& other : npcs) {
         // every call of this will check if the chunk is empty and delete it if so
-        NPCManager::destroyNPC(ref.id);
+        NPCManager::destroyNPC(other.ref.id);
     }
 }
 
+// whether a chunk lies outside of the 3x3 block of chunks centered on pos
+static inline bool outOfView(const Chunk *chunk, ChunkPos pos) {
+    int x, y, cx, cy;
+    uint64_t inst, cinst;
+    std::tie(x, y, inst) = pos;
+    std::tie(cx, cy, cinst) = chunk->pos;
+
+    return cinst != inst || std::abs(cx - x) > 1 || std::abs(cy - y) > 1;
+}
+
 void Chunking::updateEntityChunk(const EntityRef ref, ChunkPos from, ChunkPos to) {
     Entity* ent = ref.getEntity();
 
+    /*
+     * Calculate diffs. This is done to prevent phasing on chunk borders.
+     * toExit will contain old viewables - new viewables, so the player will only be exited in chunks that are out of sight.
+     * toEnter contains the opposite: new viewables - old viewables, chunks where we previously weren't visible from before.
+     *
+     * The old viewables are the ones cached on the entity. Since every chunk
+     * knows its own position, membership in the other neighbourhood is just
+     * a comparison of coordinates. For a move to an adjacent chunk this leaves
+     * a single row and/or column on either side.
+     */
+    ChunkSet toExit, toEnter;
+    for (Chunk *chunk : ent->viewableChunks)
+        if (outOfView(chunk, to))
+            toExit.chunks[toExit.count++] = chunk; // chunks we must be EXITed from (old - new)
+    for (Chunk *chunk : getViewableChunks(to))
+        if (outOfView(chunk, from))
+            toEnter.chunks[toEnter.count++] = chunk; // chunks we must be ENTERed into (new - old)
+
+    /*
+     * Update views while we're still tracked in the old chunk; untracking
+     * might free it, and it can be part of toExit. We skip ourselves either
+     * way, so it doesn't matter which chunk we're in while doing this.
+     */
+    removeEntityFromChunks(toExit, ref);
+    addEntityToChunks(toEnter, ref);
+
     // move to other chunk's player set
     untrackEntity(from, ref); // this will delete the chunk if it's empty
 
@@ -175,54 +516,57 @@ void Chunking::updateEntityChunk(const EntityRef ref, ChunkPos from, ChunkPos to
 
     trackEntity(to, ref);
 
-    // calculate viewable chunks from both points
-    std::set<Chunk*> oldViewables = getViewableChunks(from);
-    std::set<Chunk*> newViewables = getViewableChunks(to);
-    std::set<Chunk*> toExit, toEnter;
+    ent->chunkPos = to; // update cached chunk position
+    // updated cached viewable chunks
+    ent->viewableChunks = getViewableChunks(to);
+}
 
-    /*
-     * Calculate diffs. This is done to prevent phasing on chunk borders.
-     * toExit will contain old viewables - new viewables, so the player will only be exited in chunks that are out of sight.
-     * toEnter contains the opposite: new viewables - old viewables, chunks where we previously weren't visible from before.
-     */
-    std::set_difference(oldViewables.begin(), oldViewables.end(), newViewables.begin(), newViewables.end(),
-        std::inserter(toExit, toExit.end())); // chunks we must be EXITed from (old - new)
-    std::set_difference(newViewables.begin(), newViewables.end(), oldViewables.begin(), oldViewables.end(),
-        std::inserter(toEnter, toEnter.end())); // chunks we must be ENTERed into (new - old)
+Chunk *Chunking::getChunk(ChunkPos chunk) {
+    int x, y;
+    uint64_t inst;
+    std::tie(x, y, inst) = chunk;
 
-    // update views
-    removeEntityFromChunks(toExit, ref);
-    addEntityToChunks(toEnter, ref);
+    auto it = grids.find(inst);
+    if (it == grids.end())
+        return nullptr;
 
-    ent->chunkPos = to; // update cached chunk position
-    // updated cached viewable chunks
-    ent->viewableChunks.clear();
-    ent->viewableChunks.insert(newViewables.begin(), newViewables.end());
+    return it->second.find(x, y);
 }
 
 bool Chunking::chunkExists(ChunkPos chunk) {
-    return chunks.find(chunk) != chunks.end();
+    return getChunk(chunk) != nullptr;
 }
 
 ChunkPos Chunking::chunkPosAt(int posX, int posY, uint64_t instanceID) {
     return ChunkPos(posX / (settings::VIEWDISTANCE / 3), posY / (settings::VIEWDISTANCE / 3), instanceID);
 }
 
-std::set<Chunk*> Chunking::getViewableChunks(ChunkPos chunk) {
-    std::set<Chunk*> chnks;
+ChunkSet Chunking::getViewableChunks(ChunkPos chunk) {
+    ChunkSet chnks;
+
+    // fast path: an existing chunk already knows its surroundings
+    Chunk *center = getChunk(chunk);
+    if (center != nullptr) {
+        for (Chunk *c : center->neighbors)
+            if (c != nullptr)
+                chnks.chunks[chnks.count++] = c;
+        return chnks;
+    }
 
     int x, y;
     uint64_t inst;
     std::tie(x, y, inst) = chunk;
 
+    auto it = grids.find(inst);
+    if (it == grids.end())
+        return chnks;
+
     // grabs surrounding chunks if they exist
     for (int i = -1; i < 2; i++) {
         for (int z = -1; z < 2; z++) {
-            ChunkPos pos = ChunkPos(x+i, y+z, inst);
-
-            // if chunk exists, add it to the set
-            if (chunkExists(pos))
-                chnks.insert(chunks[pos]);
+            Chunk *c = it->second.find(x+i, y+z);
+            if (c != nullptr)
+                chnks.chunks[chnks.count++] = c;
         }
     }
 
@@ -230,16 +574,19 @@ std::set<Chunk*> Chunking::getViewableChunks(ChunkPos chunk) {
 }
 
 /*
- * inefficient algorithm to get all chunks from a specific instance
+ * get all chunks from a specific instance
  */
 std::vector<ChunkPos> Chunking::getChunksInMap(uint64_t mapNum) {
     std::vector<ChunkPos> chnks;
 
-    for (auto it = chunks.begin(); it != chunks.end(); it++) {
-        if (std::get<2>(it->first) == mapNum) {
-            chnks.push_back(it->first);
-        }
-    }
+    auto it = grids.find(mapNum);
+    if (it == grids.end())
+        return chnks;
+
+    chnks.reserve(it->second.size());
+    it->second.forEach([&](Chunk *chunk) {
+        chnks.push_back(chunk->pos);
+    });
 
     return chnks;
 }
@@ -247,9 +594,9 @@ std::vector<ChunkPos> Chunking::getChunksInMap(uint64_t mapNum) {
 /*
  * Used only for eggs; use npc->playersInView for everything visible
  */
-bool Chunking::inPopulatedChunks(std::set<Chunk*>* chnks) {
-    for (auto it = chnks->begin(); it != chnks->end(); it++) {
-        if ((*it)->nplayers > 0)
+bool Chunking::inPopulatedChunks(const ChunkSet& chnks) {
+    for (Chunk *chunk : chnks) {
+        if (!chunk->players.empty())
             return true;
     }
 
@@ -267,12 +614,9 @@ void Chunking::createInstance(uint64_t instanceID) {
 
     std::cout << "Creating instance " << instanceID << std::endl;
     for (ChunkPos &coords : templateChunks) {
-        for (const EntityRef ref : chunks[coords]->entities) {
-            if (ref.kind == EntityKind::PLAYER)
-                continue;
-
-            int npcID = ref.id;
-            BaseNPC* baseNPC = (BaseNPC*)ref.getEntity();
+        for (const ChunkEntity& other : getChunk(coords)->npcs) {
+            int npcID = other.ref.id;
+            BaseNPC* baseNPC = (BaseNPC*)other.ent;
 
             // make a copy of each NPC in the template chunks and put them in the new instance
             if (baseNPC->kind == EntityKind::MOB) {
@@ -280,7 +624,7 @@ void Chunking::createInstance(uint64_t instanceID) {
                     continue; // follower; don't copy individually
 
                 Mob* newMob = new Mob(baseNPC->x, baseNPC->y, baseNPC->z, baseNPC->angle,
-                    instanceID, baseNPC->type, NPCManager::NPCData[baseNPC->type], NPCManager::nextId--);
+                    instanceID, baseNPC->type, &MobAI::Templates[baseNPC->type], NPCManager::nextId--);
                 NPCManager::NPCs[newMob->id] = newMob;
 
                 // if in a group, copy over group members as well
@@ -293,7 +637,7 @@ void Chunking::createInstance(uint64_t instanceID) {
                             BaseNPC* baseFollower = NPCManager::NPCs[mobData->groupMember[i]]; // follower from template
                             // new follower instance
                             Mob* newMobFollower = new Mob(baseFollower->x, baseFollower->y, baseFollower->z, baseFollower->angle,
-                                instanceID, baseFollower->type, NPCManager::NPCData[baseFollower->type], followerID);
+                                instanceID, baseFollower->type, &MobAI::Templates[baseFollower->type], followerID);
                             // add follower to NPC maps
                             NPCManager::NPCs[followerID] = newMobFollower;
                             // set follower-specific properties
@@ -334,9 +678,9 @@ void Chunking::destroyInstanceIfEmpty(uint64_t instanceID) {
     std::vector<ChunkPos> sourceChunkCoords = getChunksInMap(instanceID);
 
     for (ChunkPos& coords : sourceChunkCoords) {
-        Chunk* chunk = chunks[coords];
+        Chunk* chunk = getChunk(coords);
 
-        if (chunk->nplayers > 0)
+        if (!chunk->players.empty())
             return; // there are still players inside
     }
 
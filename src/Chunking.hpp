@@ -2,16 +2,8 @@
 
 #include "EntityRef.hpp"
 
-#include <set>
-#include <map>
 #include <vector>
 
-class Chunk {
-public:
-    std::set<EntityRef> entities;
-    int nplayers = 0;
-};
-
 // to help the readability of ChunkPos
 typedef std::tuple<int, int, uint64_t> _ChunkPos;
 
@@ -21,6 +13,83 @@ public:
     ChunkPos(int x, int y, uint64_t inst) : _ChunkPos(x, y, inst) {}
 };
 
+class Chunk;
+
+/*
+ * The chunks in a 3x3 block around some position; never more than 9.
+ * Fixed-capacity so that viewable chunk queries don't allocate.
+ */
+struct ChunkSet {
+    Chunk *chunks[9];
+    int count = 0;
+
+    Chunk **begin() { return chunks; }
+    Chunk **end() { return chunks + count; }
+    Chunk *const *begin() const { return chunks; }
+    Chunk *const *end() const { return chunks + count; }
+    size_t size() const { return count; }
+
+    bool contains(const Chunk *chunk) const {
+        for (int i = 0; i < count; i++)
+            if (chunks[i] == chunk)
+                return true;
+        return false;
+    }
+
+    void insert(Chunk *chunk) {
+        if (!contains(chunk))
+            chunks[count++] = chunk;
+    }
+
+    void erase(const Chunk *chunk) {
+        for (int i = 0; i < count; i++) {
+            if (chunks[i] == chunk) {
+                chunks[i] = chunks[--count];
+                return;
+            }
+        }
+    }
+
+    void clear() { count = 0; }
+};
+
+/*
+ * An entity tracked by a chunk. The pointer is cached so iterating over a
+ * chunk doesn't need the lookup in EntityRef::getEntity().
+ */
+struct ChunkEntity {
+    EntityRef ref;
+    Entity *ent;
+};
+
+// where a player tracked by a chunk is, packed tightly for proximity scans
+struct PlayerPos {
+    int x, y, z;
+};
+
+class Chunk {
+public:
+    ChunkPos pos;
+
+    /*
+     * Unordered and contiguous. Each entity remembers its position in
+     * its chunk's array (Entity::chunkIndex) so removal is a swap with
+     * the last element.
+     */
+    std::vector<ChunkEntity> players;
+    std::vector<ChunkEntity> npcs; // everything that isn't a player
+    std::vector<PlayerPos> playerPos; // parallel to players
+
+    /*
+     * The 3x3 block of chunks centered on this one, indexed by
+     * (dx+1)*3 + (dy+1). Null where there's no chunk; [4] is this chunk.
+     * Kept up to date as chunks are created and deleted.
+     */
+    Chunk *neighbors[9] = {};
+
+    bool empty() const { return players.empty() && npcs.empty(); }
+};
+
 enum {
     INSTANCE_OVERWORLD, // default instance every player starts in
     INSTANCE_IZ, // these aren't actually used
@@ -28,24 +97,24 @@ enum {
 };
 
 namespace Chunking {
-    extern std::map<ChunkPos, Chunk*> chunks;
-
     extern const ChunkPos INVALID_CHUNK;
 
     void updateEntityChunk(const EntityRef ref, ChunkPos from, ChunkPos to);
 
     void trackEntity(ChunkPos chunkPos, const EntityRef ref);
     void untrackEntity(ChunkPos chunkPos, const EntityRef ref);
+    void updatePlayerPos(const EntityRef ref);
 
-    void addEntityToChunks(std::set<Chunk*> chnks, const EntityRef ref);
-    void removeEntityFromChunks(std::set<Chunk*> chnks, const EntityRef ref);
+    void addEntityToChunks(const ChunkSet& chnks, const EntityRef ref);
+    void removeEntityFromChunks(const ChunkSet& chnks, const EntityRef ref);
 
+    Chunk *getChunk(ChunkPos chunk);
     bool chunkExists(ChunkPos chunk);
     ChunkPos chunkPosAt(int posX, int posY, uint64_t instanceID);
-    std::set<Chunk*> getViewableChunks(ChunkPos chunkPos);
+    ChunkSet getViewableChunks(ChunkPos chunkPos);
     std::vector<ChunkPos> getChunksInMap(uint64_t mapNum);
 
-    bool inPopulatedChunks(std::set<Chunk*>* chnks);
+    bool inPopulatedChunks(const ChunkSet& chnks);
     void createInstance(uint64_t);
     void destroyInstanceIfEmpty(uint64_t);
 }
@@ -311,6 +311,7 @@ void CombatNPC::step(time_t currTime) {
 
 void CombatNPC::transition(AIState newState, EntityRef src) {
     state = newState;
+    NPCManager::wakeNPC(this);
 
     if (transitionHandlers.find(newState) != transitionHandlers.end())
         transitionHandlers[newState](this, src);
@@ -336,7 +337,7 @@ static std::pair<int,int> getDamage(int attackPower, int defensePower, bool shou
     // base calculation
     int damage = attackPower * attackPower / (attackPower + defensePower);
     damage = std::max(10 + attackPower / 10, damage - (defensePower - attackPower / 6) * difficulty / 100);
-    damage = damage * (Rand::rand(40) + 80) / 100;
+    damage = damage * (Rand::rand(40, Rand::Stream::COMBAT) + 80) / 100;
 
     // Adaptium/Blastons/Cosmix
     if (attackerStyle != -1 && defenderStyle != -1 && attackerStyle != defenderStyle) {
@@ -357,7 +358,7 @@ static std::pair<int,int> getDamage(int attackPower, int defensePower, bool shou
     ret.first = damage;
     ret.second = 1;
 
-    if (shouldCrit && Rand::rand(20) == 0) {
+    if (shouldCrit && Rand::rand(20, Rand::Stream::COMBAT) == 0) {
         ret.first *= 2; // critical hit
         ret.second = 2;
     }
@@ -437,9 +438,9 @@ static void pcAttackNpcs(CNSocket *sock, CNPacketData *data) {
         else
             damage.first = plr->pointDamage;
 
-        int difficulty = (int)mob->data["m_iNpcLevel"];
-        damage = getDamage(damage.first, (int)mob->data["m_iProtection"], true, (plr->batteryW > 6 + difficulty),
-            Nanos::nanoStyle(plr->activeNano), (int)mob->data["m_iNpcStyle"], difficulty);
+        int difficulty = mob->tmpl->level;
+        damage = getDamage(damage.first, mob->tmpl->protection, true, (plr->batteryW > 6 + difficulty),
+            Nanos::nanoStyle(plr->activeNano), mob->tmpl->npcStyle, difficulty);
 
         if (plr->batteryW >= 6 + difficulty)
             plr->batteryW -= 6 + difficulty;
@@ -472,7 +473,7 @@ void Combat::npcAttackPc(Mob *mob, time_t currTime) {
 
     INITVARPACKET(respbuf, sP_FE2CL_NPC_ATTACK_PCs, pkt, sAttackResult, atk);
 
-    auto damage = getDamage(450 + (int)mob->data["m_iPower"], plr->defense, true, false, -1, -1, 0);
+    auto damage = getDamage(450 + mob->tmpl->power, plr->defense, true, false, -1, -1, 0);
 
     if (!(plr->iSpecialState & CN_SPECIAL_STATE_FLAG__INVULNERABLE))
         plr->HP -= damage.first;
@@ -507,7 +508,7 @@ void Combat::genQItemRolls(std::vector<Player*> players, std::map<int, int>& rol
         Player* member = players[i];
         for (int j = 0; j < ACTIVE_MISSION_COUNT; j++)
             if (member->tasks[j] != 0)
-                rolls[member->tasks[j]] = Rand::rand();
+                rolls[member->tasks[j]] = Rand::rand(Rand::Stream::DROPS);
     }
 }
 
@@ -685,9 +686,9 @@ static void pcAttackChars(CNSocket *sock, CNPacketData *data) {
 
             Mob* mob = (Mob*)npc;
             target = mob;
-            int difficulty = (int)mob->data["m_iNpcLevel"];
-            damage = getDamage(damage.first, (int)mob->data["m_iProtection"], true, (plr->batteryW > 6 + difficulty),
-                Nanos::nanoStyle(plr->activeNano), (int)mob->data["m_iNpcStyle"], difficulty);
+            int difficulty = mob->tmpl->level;
+            damage = getDamage(damage.first, mob->tmpl->protection, true, (plr->batteryW > 6 + difficulty),
+                Nanos::nanoStyle(plr->activeNano), mob->tmpl->npcStyle, difficulty);
         }
 
         if (plr->batteryW >= 6 + plr->level)
@@ -741,7 +742,7 @@ static int8_t addBullet(Player* plr, bool isGrenade) {
     // temp solution Jade fix plz
     toAdd.weaponBoost = plr->batteryW > 0;
     if (toAdd.weaponBoost) {
-        int boostCost = Rand::rand(11) + 20;
+        int boostCost = Rand::rand(11, Rand::Stream::COMBAT) + 20;
         plr->batteryW = boostCost > plr->batteryW ? 0 : plr->batteryW - boostCost;
     }
 
@@ -879,8 +880,8 @@ static void projectileHit(CNSocket* sock, CNPacketData* data) {
 
         damage.first = pkt->iTargetCnt > 1 ? bullet->groupDamage : bullet->pointDamage;
 
-        int difficulty = (int)mob->data["m_iNpcLevel"];
-        damage = getDamage(damage.first, (int)mob->data["m_iProtection"], true, bullet->weaponBoost, Nanos::nanoStyle(plr->activeNano), (int)mob->data["m_iNpcStyle"], difficulty);
+        int difficulty = mob->tmpl->level;
+        damage = getDamage(damage.first, mob->tmpl->protection, true, bullet->weaponBoost, Nanos::nanoStyle(plr->activeNano), mob->tmpl->npcStyle, difficulty);
 
         damage.first = mob->takeDamage(sock, damage.first);
 
@@ -1,6 +1,7 @@
 #include "CustomCommands.hpp"
 
 #include "db/Database.hpp"
+#include "servers/CNShardServer.hpp"
 
 #include "Player.hpp"
 #include "PlayerManager.hpp"
@@ -12,6 +13,8 @@
 #include "Eggs.hpp"
 #include "Items.hpp"
 #include "Abilities.hpp"
+#include "PlayerMovement.hpp"
+#include "settings.hpp"
 
 #include <sstream>
 #include <limits.h>
@@ -90,6 +93,26 @@ static void populationCommand(std::string full, std::vector<std::string>& args,
     Chat::sendServerMessage(sock, std::to_string(PlayerManager::players.size()) + " players online");
 }
 
+static void timersCommand(std::string full, std::vector<std::string>& args, CNSocket* sock) {
+    for (TimerEvent& event : CNShardServer::Timers) {
+        time_t avgLateness = event.runs > 0 ? event.totalLateness / (time_t)event.runs : 0;
+
+        Chat::sendServerMessage(sock, std::string(event.name) + ": every " + std::to_string(event.delta)
+            + "ms, late by " + std::to_string(avgLateness) + "ms avg/" + std::to_string(event.maxLateness)
+            + "ms max, ran for " + std::to_string(event.maxRuntime) + "ms max");
+    }
+}
+
+static void moveStatsCommand(std::string full, std::vector<std::string>& args, CNSocket* sock) {
+    PlayerMovement::MoveStats& stats = PlayerMovement::stats;
+    uint64_t saved = stats.full - stats.sent;
+    size_t packetSize = sizeof(sP_FE2CL_PC_MOVE) + 8; // plus the length and type
+
+    Chat::sendServerMessage(sock, std::string("Dead reckoning is ") + (settings::DEADRECKONING ? "on" : "off"));
+    Chat::sendServerMessage(sock, std::to_string(stats.sent) + " of " + std::to_string(stats.full)
+        + " movement updates sent, " + std::to_string(saved * packetSize / 1024) + "KiB saved");
+}
+
 static void levelCommand(std::string full, std::vector<std::string>& args, CNSocket* sock) {
     if (args.size() < 2) {
         Chat::sendServerMessage(sock, "/level: no level specified");
@@ -692,11 +715,8 @@ static void lairUnlockCommand(std::string full, std::vector<std::string>& args,
     int missionID = -1;
     int lastDist = INT_MAX;
     for (Chunk *chnk : Chunking::getViewableChunks(plr->chunkPos)) {
-        for (const EntityRef& ref : chnk->entities) {
-            if (ref.kind == EntityKind::PLAYER)
-                continue;
-
-            BaseNPC* npc = (BaseNPC*)ref.getEntity();
+        for (const ChunkEntity& other : chnk->npcs) {
+            BaseNPC* npc = (BaseNPC*)other.ent;
 
             int distXY = std::hypot(plr->x - npc->x, plr->y - npc->y);
             int dist = std::hypot(distXY, plr->z - npc->z);
@@ -1018,7 +1038,7 @@ static void pathCommand(std::string full, std::vector<std::string>& args, CNSock
     // /path here
     if (args[1] == "here") {
         // bring the NPC to where the player is standing
-        Transport::NPCQueues.erase(npc->id); // delete transport queue
+        Transport::NPCRoutes.erase(npc->id); // delete transport route
         NPCManager::updateNPCPosition(npc->id, plr->x, plr->y, plr->z, npc->instanceID, 0);
         npc->disappearFromViewOf(sock);
         npc->enterIntoViewOf(sock);
@@ -1057,7 +1077,7 @@ static void pathCommand(std::string full, std::vector<std::string>& args, CNSock
             speed = speedArg;
         }
         // return NPC to home
-        Transport::NPCQueues.erase(npc->id); // delete transport queue
+        Transport::NPCRoutes.erase(npc->id); // delete transport route
         BaseNPC* home = entry->second[0];
         NPCManager::updateNPCPosition(npc->id, home->x, home->y, home->z, npc->instanceID, 0);
         npc->disappearFromViewOf(sock);
@@ -1065,17 +1085,17 @@ static void pathCommand(std::string full, std::vector<std::string>& args, CNSock
 
         // do lerping magic
         entry->second.push_back(home); // temporary end point for loop completion
-        std::queue<Vec3> keyframes;
+        std::vector<Vec3> keyframes;
         auto _point = entry->second.begin();
         Vec3 from = { (*_point)->x, (*_point)->y, (*_point)->z }; // point A coords
         for (_point++; _point != entry->second.end(); _point++) { // loop through all point Bs
             Vec3 to = { (*_point)->x, (*_point)->y, (*_point)->z }; // point B coords
-            // add point A to the queue
-            keyframes.push(from);
+            // add point A to the route
+            keyframes.push_back(from);
             Transport::lerp(&keyframes, from, to, speed); // lerp from A to B
             from = to; // update point A
         }
-        Transport::NPCQueues[npc->id] = keyframes;
+        Transport::NPCRoutes[npc->id] = NPCRoute(std::move(keyframes));
         entry->second.pop_back(); // remove temp end point
 
         Chat::sendServerMessage(sock, "[PATH] Testing NPC path");
@@ -1085,7 +1105,7 @@ static void pathCommand(std::string full, std::vector<std::string>& args, CNSock
     // /path cancel
     if (args[1] == "cancel") {
         // return NPC to home
-        Transport::NPCQueues.erase(npc->id); // delete transport queue
+        Transport::NPCRoutes.erase(npc->id); // delete transport route
         BaseNPC* home = entry->second[0];
         NPCManager::updateNPCPosition(npc->id, home->x, home->y, home->z, npc->instanceID, 0);
         npc->disappearFromViewOf(sock);
@@ -1125,7 +1145,7 @@ static void pathCommand(std::string full, std::vector<std::string>& args, CNSock
         }
 
         // return NPC to home and set path to repeat
-        Transport::NPCQueues.erase(npc->id); // delete transport queue
+        Transport::NPCRoutes.erase(npc->id); // delete transport route
         BaseNPC* home = entry->second[0];
         NPCManager::updateNPCPosition(npc->id, home->x, home->y, home->z, npc->instanceID, 0);
         npc->disappearFromViewOf(sock);
@@ -1134,17 +1154,17 @@ static void pathCommand(std::string full, std::vector<std::string>& args, CNSock
 
         // do lerping magic
         entry->second.push_back(home); // temporary end point for loop completion
-        std::queue<Vec3> keyframes;
+        std::vector<Vec3> keyframes;
         auto _point = entry->second.begin();
         Vec3 from = { (*_point)->x, (*_point)->y, (*_point)->z }; // point A coords
         for (_point++; _point != entry->second.end(); _point++) { // loop through all point Bs
             Vec3 to = { (*_point)->x, (*_point)->y, (*_point)->z }; // point B coords
-            // add point A to the queue
-            keyframes.push(from);
+            // add point A to the route
+            keyframes.push_back(from);
             Transport::lerp(&keyframes, from, to, speed); // lerp from A to B
             from = to; // update point A
         }
-        Transport::NPCQueues[npc->id] = keyframes;
+        Transport::NPCRoutes[npc->id] = NPCRoute(std::move(keyframes));
         entry->second.pop_back(); // remove temp end point
 
         // save to gruntwork
@@ -1212,6 +1232,8 @@ void CustomCommands::init() {
     registerCommand("level", 50, levelCommand, "change your character's level");
     registerCommand("levelx", 50, levelCommand, "change your character's level"); // for Academy
     registerCommand("population", 100, populationCommand, "check how many players are online");
+    registerCommand("timers", 30, timersCommand, "show how late the server's timers are running");
+    registerCommand("movestats", 30, moveStatsCommand, "show how many player movement updates were sent");
     registerCommand("refresh", 100, refreshCommand, "teleport yourself to your current location");
     registerCommand("minfo", 30, minfoCommand, "show details of the current mission and task.");
     registerCommand("buff", 50, buffCommand, "give yourself a buff effect");
@@ -111,7 +111,7 @@ static void eggStep(CNServer* serv, time_t currTime) {
             continue;
 
         auto egg = (Egg*)npc.second;
-        if (!egg->dead || !Chunking::inPopulatedChunks(&egg->viewableChunks))
+        if (!egg->dead || !Chunking::inPopulatedChunks(egg->viewableChunks))
             continue;
 
         if (egg->deadUntil <= currTime) {
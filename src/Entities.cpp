@@ -66,27 +66,31 @@ void BaseNPC::enterIntoViewOf(CNSocket *sock) {
     sock->sendPacket(pkt, P_FE2CL_NPC_ENTER);
 }
 
-void Bus::enterIntoViewOf(CNSocket *sock) {
-    INITSTRUCT(sP_FE2CL_TRANSPORTATION_ENTER, pkt);
-
+sTransportationAppearanceData Bus::getTransportationAppearanceData() {
     // TODO: Potentially decouple this from BaseNPC?
-    pkt.AppearanceData = {
+    return {
         3, id, type,
         x, y, z
     };
+}
 
+void Bus::enterIntoViewOf(CNSocket *sock) {
+    INITSTRUCT(sP_FE2CL_TRANSPORTATION_ENTER, pkt);
+    pkt.AppearanceData = getTransportationAppearanceData();
     sock->sendPacket(pkt, P_FE2CL_TRANSPORTATION_ENTER);
 }
 
-void Egg::enterIntoViewOf(CNSocket *sock) {
-    INITSTRUCT(sP_FE2CL_SHINY_ENTER, pkt);
-
+sShinyAppearanceData Egg::getShinyAppearanceData() {
     // TODO: Potentially decouple this from BaseNPC?
-    pkt.ShinyAppearanceData = {
+    return {
         id, type, 0, // client doesn't care about map num
         x, y, z
     };
+}
 
+void Egg::enterIntoViewOf(CNSocket *sock) {
+    INITSTRUCT(sP_FE2CL_SHINY_ENTER, pkt);
+    pkt.ShinyAppearanceData = getShinyAppearanceData();
     sock->sendPacket(pkt, P_FE2CL_SHINY_ENTER);
 }
 
@@ -24,7 +24,8 @@ struct Entity {
     int x = 0, y = 0, z = 0;
     uint64_t instanceID = 0;
     ChunkPos chunkPos = {};
-    std::set<Chunk*> viewableChunks = {};
+    int chunkIndex = -1; // in chunk->players or chunk->npcs
+    ChunkSet viewableChunks = {};
 
     // destructor must be virtual, apparently
     virtual ~Entity() {}
@@ -100,6 +101,7 @@ struct CombatNPC : public BaseNPC, public ICombatant {
     AIState state = AIState::INACTIVE;
     Group* group = nullptr;
     int playersInView = 0; // for optimizing away AI in empty chunks
+    int activeIndex = -1; // in the list of NPCs to step; see NPCManager::wakeNPC()
 
     std::map<AIState, void (*)(CombatNPC*, time_t)> stateHandlers;
     std::map<AIState, void (*)(CombatNPC*, EntityRef)> transitionHandlers;
@@ -122,6 +124,9 @@ struct CombatNPC : public BaseNPC, public ICombatant {
 
     virtual bool isExtant() override { return hp > 0; }
 
+    // whether this NPC currently needs to be stepped every combat tick
+    virtual bool isActive() { return true; }
+
     virtual bool addBuff(int buffId, BuffCallback<int, BuffStack*> onUpdate, BuffCallback<time_t> onTick, BuffStack* stack) override;
     virtual Buff* getBuff(int buffId) override;
     virtual void removeBuff(int buffId) override;
@@ -161,6 +166,8 @@ struct Egg : public BaseNPC {
 
     virtual void enterIntoViewOf(CNSocket *sock) override;
     virtual void disappearFromViewOf(CNSocket *sock) override;
+
+    sShinyAppearanceData getShinyAppearanceData();
 };
 
 struct Bus : public BaseNPC {
@@ -172,4 +179,6 @@ struct Bus : public BaseNPC {
 
     virtual void enterIntoViewOf(CNSocket *sock) override;
     virtual void disappearFromViewOf(CNSocket *sock) override;
+
+    sTransportationAppearanceData getTransportationAppearanceData();
 };
@@ -14,6 +14,7 @@
 #include <string.h> // for memset()
 #include <assert.h>
 #include <numeric>
+#include <unordered_map>
 
 using namespace Items;
 
@@ -103,17 +104,48 @@ static int choice(const std::vector<int>& weights, int rolled) {
     return currentIndex;
 }
 
-static int getRarity(int crateId, int itemSetId) {
-    Crate& crate = Items::Crates[crateId];
+/*
+ * Everything a crate roll depends on is fixed once the drops are loaded, so the
+ * rarity odds of each crate and the candidate items of each item set are worked
+ * out ahead of time, and opening a crate is just two draws from those.
+ */
+
+// every item of an item set that can drop for one rarity and gender
+struct ItemPool {
+    std::vector<ItemReference*> items;
+    Rand::WeightedTable weights;
+};
+
+// genders other than boy (1) or girl (2) only get gender-neutral items
+#define POOL_GENDERS 3
+
+static std::unordered_map<int32_t, Rand::WeightedTable> crateRarities; // crate id -> rarity - 1
+static std::unordered_map<int32_t, std::vector<ItemPool>> itemSetPools; // item set id -> pool for (rarity - 1, gender)
+static int maxRarity = 1; // a crate with no rarity weights still rolls commons
+
+static int getItemRarity(ItemSet& itemSet, int itemReferenceId) {
+    auto it = itemSet.alterRarityMap.find(itemReferenceId);
+    return it == itemSet.alterRarityMap.end() ? Items::ItemReferences[itemReferenceId].rarity : it->second;
+}
+
+static int getItemGender(ItemSet& itemSet, int itemReferenceId) {
+    auto it = itemSet.alterGenderMap.find(itemReferenceId);
+    return it == itemSet.alterGenderMap.end() ? Items::ItemReferences[itemReferenceId].gender : it->second;
+}
 
+static void buildRarityTable(int crateId, Crate& crate) {
     // find rarity ratio
     if (Items::RarityWeights.find(crate.rarityWeightId) == Items::RarityWeights.end()) {
         std::cout << "[WARN] Rarity Weight " << crate.rarityWeightId << " not found!" << std::endl;
-        return -1;
+        return;
     }
 
+    // an invalid item set is reported when the crate gets opened
+    if (Items::ItemSets.find(crate.itemSetId) == Items::ItemSets.end())
+        return;
+
     std::vector<int>& rarityWeights = Items::RarityWeights[crate.rarityWeightId];
-    ItemSet& itemSet = Items::ItemSets[itemSetId];
+    ItemSet& itemSet = Items::ItemSets[crate.itemSetId];
 
     /*
      * First we have to check if specified item set contains items with all specified rarities,
@@ -128,12 +160,7 @@ static int getRarity(int crateId, int itemSetId) {
         if (Items::ItemReferences.find(itemReferenceId) == Items::ItemReferences.end())
             continue;
 
-        // alter rarity
-        int itemRarity = (itemSet.alterRarityMap.find(itemReferenceId) == itemSet.alterRarityMap.end())
-            ? Items::ItemReferences[itemReferenceId].rarity
-            : itemSet.alterRarityMap[itemReferenceId];
-
-        rarityIndices.insert(itemRarity - 1);
+        rarityIndices.insert(getItemRarity(itemSet, itemReferenceId) - 1);
 
         // shortcut
         if (rarityIndices.size() == rarityWeights.size())
@@ -142,7 +169,7 @@ static int getRarity(int crateId, int itemSetId) {
 
     if (rarityIndices.empty()) {
         std::cout << "[WARN] Item Set " << crate.itemSetId << " has no valid items assigned?!" << std::endl;
-        return -1;
+        return;
     }
 
     // retain the weights of rarities that actually exist in the itemset
@@ -153,18 +180,17 @@ static int getRarity(int crateId, int itemSetId) {
             relevantWeights[index] = rarityWeights[index];
     }
 
-    // now return a random rarity number (starting from 1)
     // if relevantWeights is empty or all zeros, we default to giving a common (1) item
     // rarity 0 items will appear in the drop pool regardless of this roll
-    return Rand::randWeighted(relevantWeights) + 1;
+    crateRarities[crateId] = Rand::WeightedTable(relevantWeights);
 }
 
-static int getCrateItem(sItemBase* result, int itemSetId, int rarity, int playerGender) {
-    ItemSet& itemSet = Items::ItemSets[itemSetId];
-
-    // collect valid items that match the rarity and gender (if not ignored)
-    std::vector<std::pair<int, ItemReference*>> validItems;
+static void buildItemPools(int itemSetId, ItemSet& itemSet) {
+    std::vector<ItemPool>& pools = itemSetPools[itemSetId];
+    pools.resize(maxRarity * POOL_GENDERS);
 
+    // skip over missing items once, rather than on every roll
+    std::vector<int> itemReferenceIds;
     for (int itemReferenceId : itemSet.itemReferenceIds) {
         if (Items::ItemReferences.find(itemReferenceId) == Items::ItemReferences.end()) {
             std::cout << "[WARN] Item reference " << itemReferenceId << " in item set type "
@@ -172,55 +198,77 @@ static int getCrateItem(sItemBase* result, int itemSetId, int rarity, int player
             continue;
         }
 
-        ItemReference* item = &Items::ItemReferences[itemReferenceId];
+        itemReferenceIds.push_back(itemReferenceId);
+    }
 
-        // alter rarity
-        int itemRarity = (itemSet.alterRarityMap.find(itemReferenceId) == itemSet.alterRarityMap.end())
-            ? item->rarity
-            : itemSet.alterRarityMap[itemReferenceId];
+    for (int rarity = 1; rarity <= maxRarity; rarity++) {
+        for (int playerGender = 0; playerGender < POOL_GENDERS; playerGender++) {
+            ItemPool& pool = pools[(rarity - 1) * POOL_GENDERS + playerGender];
+            std::vector<int> itemWeights;
 
-        // if rarity doesn't match the selected one, exclude item
-        // rarity 0 bypasses this step for an individual item
-        if (!itemSet.ignoreRarity && itemRarity != 0 && itemRarity != rarity)
-            continue;
+            // collect valid items that match the rarity and gender (if not ignored)
+            for (int itemReferenceId : itemReferenceIds) {
+                // if rarity doesn't match the selected one, exclude item
+                // rarity 0 bypasses this step for an individual item
+                int itemRarity = getItemRarity(itemSet, itemReferenceId);
+                if (!itemSet.ignoreRarity && itemRarity != 0 && itemRarity != rarity)
+                    continue;
 
-        // alter rarity
-        int itemGender = (itemSet.alterGenderMap.find(itemReferenceId) == itemSet.alterGenderMap.end())
-            ? item->gender
-            : itemSet.alterGenderMap[itemReferenceId];
+                // if gender is incorrect, exclude item
+                // gender 0 bypasses this step for an individual item
+                int itemGender = getItemGender(itemSet, itemReferenceId);
+                if (!itemSet.ignoreGender && itemGender != 0 && itemGender != playerGender)
+                    continue;
 
-        // if gender is incorrect, exclude item
-        // gender 0 bypasses this step for an individual item
-        if (!itemSet.ignoreGender && itemGender != 0 && itemGender != playerGender)
-            continue;
+                // items start out with the default weight of the item set
+                int weight = itemSet.defaultItemWeight;
 
-        validItems.push_back(std::make_pair(itemReferenceId, item));
-    }
+                auto it = itemSet.alterItemWeightMap.find(itemReferenceId);
+                // allow 0 weights for convenience
+                if (it != itemSet.alterItemWeightMap.end() && it->second > -1)
+                    weight = it->second;
 
-    if (validItems.empty()) {
-        std::cout << "[WARN] Set ID " << itemSetId << " Rarity " << rarity << " contains no valid items" << std::endl;
-        return -1;
+                pool.items.push_back(&Items::ItemReferences[itemReferenceId]);
+                itemWeights.push_back(weight);
+            }
+
+            pool.weights = Rand::WeightedTable(itemWeights);
+        }
     }
+}
 
-    // initialize all weights as the default weight for all item slots
-    std::vector<int> itemWeights(validItems.size(), itemSet.defaultItemWeight);
+static void buildDropTables() {
+    for (auto& pair : Items::RarityWeights)
+        maxRarity = std::max(maxRarity, (int)pair.second.size());
 
-    if (!itemSet.alterItemWeightMap.empty()) {
-        for (int i = 0; i < validItems.size(); i++) {
-            int itemReferenceId = validItems[i].first;
+    for (auto& pair : Items::Crates)
+        buildRarityTable(pair.first, pair.second);
 
-            if (itemSet.alterItemWeightMap.find(itemReferenceId) == itemSet.alterItemWeightMap.end())
-                continue;
+    for (auto& pair : Items::ItemSets)
+        buildItemPools(pair.first, pair.second);
+}
 
-            int weight = itemSet.alterItemWeightMap[itemReferenceId];
-            // allow 0 weights for convenience
-            if (weight > -1)
-                itemWeights[i] = weight;
-        }
+static int getRarity(int crateId) {
+    auto it = crateRarities.find(crateId);
+    if (it == crateRarities.end())
+        return -1; // already reported on load
+
+    // now return a random rarity number (starting from 1)
+    return Rand::randWeighted(it->second, Rand::Stream::DROPS) + 1;
+}
+
+static int getCrateItem(sItemBase* result, int itemSetId, int rarity, int playerGender) {
+    if (playerGender < 0 || playerGender >= POOL_GENDERS)
+        playerGender = 0;
+
+    ItemPool& pool = itemSetPools[itemSetId][(rarity - 1) * POOL_GENDERS + playerGender];
+
+    if (pool.items.empty()) {
+        std::cout << "[WARN] Set ID " << itemSetId << " Rarity " << rarity << " contains no valid items" << std::endl;
+        return -1;
     }
 
-    int chosenIndex = Rand::randWeighted(itemWeights);
-    ItemReference* item = validItems[chosenIndex].second;
+    ItemReference* item = pool.items[Rand::randWeighted(pool.weights, Rand::Stream::DROPS)];
 
     result->iID = item->itemId;
     result->iType = item->type;
@@ -588,7 +636,7 @@ static void chestOpenHandler(CNSocket *sock, CNPacketData *data) {
     failing = (validItemSetId == -1);
 
     if (!failing)
-        rarity = getRarity(validCrateId, validItemSetId);
+        rarity = getRarity(validCrateId);
     failing = (rarity == -1);
 
     if (!failing)
@@ -598,7 +646,7 @@ static void chestOpenHandler(CNSocket *sock, CNPacketData *data) {
     // if we failed to open a crate, at least give the player a gumball (suggested by Jade)
     if (failing) {
         item->sItem.iType = 7;
-        item->sItem.iID = 119 + Rand::rand(3);
+        item->sItem.iID = 119 + Rand::rand(3, Rand::Stream::DROPS);
         item->sItem.iOpt = 1;
 
         std::cout << "[WARN] Crate open failed, giving a Gumball..." << std::endl;
@@ -862,4 +910,6 @@ void Items::init() {
     // Bank
     REGISTER_SHARD_PACKET(P_CL2FE_REQ_PC_BANK_OPEN, itemBankOpenHandler);
     REGISTER_SHARD_PACKET(P_CL2FE_REQ_ITEM_CHEST_OPEN, chestOpenHandler);
+
+    buildDropTables();
 }
@@ -90,7 +90,10 @@ namespace Items {
         int taros, fm;
         int crate, crateType;
 
-        DropRoll() : boosts(Rand::rand()), potions(Rand::rand()), taros(Rand::rand()), fm(Rand::rand()), crate(Rand::rand()), crateType(Rand::rand()) { }
+        DropRoll() : boosts(roll()), potions(roll()), taros(roll()), fm(roll()), crate(roll()), crateType(roll()) { }
+
+    private:
+        static int roll() { return Rand::rand(Rand::Stream::DROPS); }
     };
     // hopefully this is fine since it's never modified after load
     extern std::map<std::pair<int32_t, int32_t>, Item> ItemData; // <id, type> -> data
@@ -368,15 +368,13 @@ static void taskStart(CNSocket* sock, CNPacketData* data) {
     // if escort task, assign matching paths to all nearby NPCs
     if (task["m_iHTaskType"] == (int)eTaskTypeProperty::EscortDefence) {
         for (ChunkPos& chunkPos : Chunking::getChunksInMap(plr->instanceID)) { // check all NPCs in the instance
-            Chunk* chunk = Chunking::chunks[chunkPos];
-            for (EntityRef ref : chunk->entities) {
-                if (ref.kind != EntityKind::PLAYER) {
-                    BaseNPC* npc = (BaseNPC*)ref.getEntity();
-                    NPCPath* path = Transport::findApplicablePath(npc->id, npc->type, missionData->iTaskNum);
-                    if (path != nullptr) {
-                        Transport::constructPathNPC(npc->id, path);
-                        return;
-                    }
+            Chunk* chunk = Chunking::getChunk(chunkPos);
+            for (const ChunkEntity& other : chunk->npcs) {
+                BaseNPC* npc = (BaseNPC*)other.ent;
+                NPCPath* path = Transport::findApplicablePath(npc->id, npc->type, missionData->iTaskNum);
+                if (path != nullptr) {
+                    Transport::constructPathNPC(npc->id, path);
+                    return;
                 }
             }
         }
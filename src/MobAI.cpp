@@ -14,10 +14,49 @@
 
 #include <cmath>
 #include <limits.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
 
 using namespace MobAI;
 
 bool MobAI::simulateMobs = settings::SIMULATEMOBS;
+std::vector<MobTemplate> MobAI::Templates;
+
+/*
+ * Must be called after NPCManager::NPCData has been loaded.
+ * Fields are read leniently since non-mob NPC types don't need them.
+ */
+void MobAI::loadTemplates() {
+    Templates.clear();
+    Templates.reserve(NPCManager::NPCData.size());
+
+    for (nlohmann::json& npc : NPCManager::NPCData) {
+        MobTemplate mt;
+        mt.hp = npc.value("m_iHP", 0);
+        mt.level = npc.value("m_iNpcLevel", 0);
+        mt.sightRange = npc.value("m_iSightRange", 0);
+        mt.idleRange = npc.value("m_iIdleRange", 0);
+        mt.combatRange = npc.value("m_iCombatRange", 0);
+        mt.runSpeed = npc.value("m_iRunSpeed", 0);
+        mt.regenTime = npc.value("m_iRegenTime", 0);
+        mt.delayTime = npc.value("m_iDelayTime", 0);
+        mt.atkRange = npc.value("m_iAtkRange", 0);
+        mt.radius = npc.value("m_iRadius", 0);
+        mt.power = npc.value("m_iPower", 0);
+        mt.protection = npc.value("m_iProtection", 0);
+        mt.npcStyle = npc.value("m_iNpcStyle", 0);
+        mt.activeSkill1 = npc.value("m_iActiveSkill1", 0);
+        mt.activeSkill1Prob = npc.value("m_iActiveSkill1Prob", 0);
+        mt.corruptionType = npc.value("m_iCorruptionType", 0);
+        mt.corruptionTypeProb = npc.value("m_iCorruptionTypeProb", 0);
+        mt.megaType = npc.value("m_iMegaType", 0);
+        mt.megaTypeProb = npc.value("m_iMegaTypeProb", 0);
+        mt.passiveBuff = npc.value("m_iPassiveBuff", 0);
+        Templates.push_back(mt);
+    }
+}
 
 void Mob::step(time_t currTime) {
     if (playersInView < 0)
@@ -162,69 +201,236 @@ void MobAI::groupRetreat(Mob *mob) {
     clearDebuff(leadMob);
 }
 
+// how far away a mob can notice this player from; negative if it can't at all
+static int aggroRange(Mob *mob, Player *plr, CNSocket *sock) {
+    if (plr->HP <= 0 || plr->onMonkey)
+        return -1;
+
+    if (plr->iSpecialState & (CN_SPECIAL_STATE_FLAG__INVISIBLE|CN_SPECIAL_STATE_FLAG__INVULNERABLE))
+        return -1;
+
+    if (mob->state != AIState::ROAMING && plr->inCombat) // freshly out of aggro mobs
+        return mob->sightRange * 2; // should not be impacted by the below
+
+    int mobRange = mob->sightRange;
+
+    if (plr->hasBuff(ECSB_UP_STEALTH)
+    || Racing::EPRaces.find(sock) != Racing::EPRaces.end())
+        mobRange /= 3;
+
+    // 0.33x - 1.66x the range
+    int levelDifference = plr->level - mob->level;
+    if (levelDifference > -10)
+        mobRange = levelDifference < 10 ? mobRange - (levelDifference * mobRange / 15) : mobRange / 3;
+
+    return mobRange;
+}
+
 /*
- * Aggro on nearby players.
+ * Find the nearest player a mob would aggro on.
  * Even if they're in range, we can't assume they're all in the same one chunk
  * as the mob, since it might be near a chunk boundary.
+ *
+ * Distances are compared squared against the chunks' packed player positions,
+ * so most players are ruled out without touching the Player itself. Only those
+ * within the furthest any player could be noticed from get the exact check.
+ *
+ * This only reads shared state, so planAggro() can run it off the shard thread.
  */
-bool MobAI::aggroCheck(Mob *mob, time_t currTime) {
+static CNSocket *findAggroTarget(Mob *mob) {
     CNSocket *closest = nullptr;
-    int closestDistance = INT_MAX;
+    int64_t closestDistance = INT64_MAX;
 
-    for (auto it = mob->viewableChunks.begin(); it != mob->viewableChunks.end(); it++) {
-        Chunk* chunk = *it;
-        for (const EntityRef& ref : chunk->entities) {
-            // TODO: support targetting other CombatNPCs
-            if (ref.kind != EntityKind::PLAYER)
-                continue;
+    // see aggroRange(); a -9 level difference gives at most 1.6x
+    int64_t maxRange = mob->state == AIState::ROAMING ? (int64_t)mob->sightRange * 8 / 5 : (int64_t)mob->sightRange * 2;
+    int64_t maxDistance = maxRange * maxRange;
+
+    for (Chunk *chunk : mob->viewableChunks) {
+        // TODO: support targetting other CombatNPCs
+        const PlayerPos *pos = chunk->playerPos.data();
+        size_t count = chunk->playerPos.size();
+
+        for (size_t i = 0; i < count; i++) {
+            // height is relevant for aggro distance because of platforming
+            int64_t dx = mob->x - pos[i].x;
+            int64_t dy = mob->y - pos[i].y;
+            int64_t dz = (int64_t)(mob->z - pos[i].z) * 2; // difference in Z counts twice
+            int64_t distance = dx * dx + dy * dy + dz * dz;
 
-            CNSocket *s = ref.sock;
-            Player *plr = PlayerManager::getPlayer(s);
+            if (distance > maxDistance || distance > closestDistance)
+                continue;
 
-            if (plr->HP <= 0 || plr->onMonkey)
+            const ChunkEntity& other = chunk->players[i];
+            int64_t mobRange = aggroRange(mob, (Player*)other.ent, other.ref.sock);
+            if (mobRange < 0 || distance > mobRange * mobRange)
                 continue;
 
-            int mobRange = mob->sightRange;
+            // found a player
+            closest = other.ref.sock;
+            closestDistance = distance;
+        }
+    }
 
-            if (plr->hasBuff(ECSB_UP_STEALTH)
-            || Racing::EPRaces.find(s) != Racing::EPRaces.end())
-                mobRange /= 3;
+    return closest;
+}
 
-            // 0.33x - 1.66x the range
-            int levelDifference = plr->level - mob->level;
-            if (levelDifference > -10)
-                mobRange = levelDifference < 10 ? mobRange - (levelDifference * mobRange / 15) : mobRange / 3;
+static bool engage(Mob *mob, CNSocket *target) {
+    if (target == nullptr)
+        return false;
 
-            if (mob->state != AIState::ROAMING && plr->inCombat) // freshly out of aggro mobs
-                mobRange = mob->sightRange * 2; // should not be impacted by the above
+    mob->transition(AIState::COMBAT, target);
 
-            if (plr->iSpecialState & (CN_SPECIAL_STATE_FLAG__INVISIBLE|CN_SPECIAL_STATE_FLAG__INVULNERABLE))
-                mobRange = -1;
+    if (mob->groupLeader != 0)
+        followToCombat(mob);
 
-            // height is relevant for aggro distance because of platforming
-            int xyDistance = hypot(mob->x - plr->x, mob->y - plr->y);
-            int distance = hypot(xyDistance, (mob->z - plr->z) * 2); // difference in Z counts twice
+    return true;
+}
 
-            if (distance > mobRange || distance > closestDistance)
-                continue;
+// Aggro on nearby players.
+bool MobAI::aggroCheck(Mob *mob, time_t currTime) {
+    return engage(mob, findAggroTarget(mob));
+}
 
-            // found a player
-            closest = s;
-            closestDistance = distance;
+/*
+ * Fork-join pool for planAggro(). The threads are started during init, before
+ * the sandbox is engaged, and then just sleep between ticks for the lifetime
+ * of the process.
+ */
+class AIWorkers {
+private:
+    int count;
+    std::mutex mtx;
+    std::condition_variable wake, done;
+    std::function<void(size_t, size_t)> job;
+    size_t jobSize = 0;
+    uint64_t generation = 0;
+    int pending = 0;
+
+    // [start, end) of the share of the current job that belongs to worker idx
+    std::pair<size_t, size_t> share(int idx) {
+        size_t parts = count + 1; // the calling thread takes the last share
+        return { jobSize * idx / parts, jobSize * (idx + 1) / parts };
+    }
+
+    void work(int idx) {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mtx);
+
+        while (true) {
+            wake.wait(lock, [&] { return generation != seen; });
+            seen = generation;
+            auto range = share(idx);
+
+            lock.unlock();
+            job(range.first, range.second);
+            lock.lock();
+
+            if (--pending == 0)
+                done.notify_one();
         }
     }
 
-    if (closest != nullptr) {
-        // found closest player. engage.
-        mob->transition(AIState::COMBAT, closest);
+public:
+    AIWorkers(int n) : count(n) {
+        for (int i = 0; i < count; i++)
+            std::thread(&AIWorkers::work, this, i).detach();
+    }
+
+    // calls fn over [0, n) split into contiguous ranges, and waits for all of them
+    void run(size_t n, const std::function<void(size_t, size_t)>& fn) {
+        std::pair<size_t, size_t> own;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            job = fn;
+            jobSize = n;
+            pending = count;
+            generation++;
+            own = share(count);
+        }
+        wake.notify_all();
 
-        if (mob->groupLeader != 0)
-            followToCombat(mob);
+        fn(own.first, own.second);
 
-        return true;
+        std::unique_lock<std::mutex> lock(mtx);
+        done.wait(lock, [&] { return pending == 0; });
     }
+};
+
+static AIWorkers *workers = nullptr;
+
+// below this, waking the workers costs more than the scans themselves
+#define MIN_PARALLEL_PLANS 64
+
+void MobAI::startWorkers(int count) {
+    if (count <= 0 || workers != nullptr)
+        return;
 
-    return false;
+    workers = new AIWorkers(count);
+    std::cout << "[INFO] Planning mob aggro on " << count << " extra thread(s)" << std::endl;
+}
+
+/*
+ * First phase of the NPC tick: every roaming mob that is due for an aggro
+ * scan this tick picks its target up front, in parallel if workers are
+ * running. Nothing is modified besides each mob's own plan, so the result
+ * only depends on the state at the start of the tick and not on how the work
+ * was split up.
+ *
+ * The second phase is the regular serial step, where roamingStep() acts on
+ * the plan; see takePlannedTarget().
+ */
+void MobAI::planAggro(const std::vector<CombatNPC*>& npcs, time_t currTime) {
+    static std::vector<Mob*> due;
+
+    if (!simulateMobs)
+        return;
+
+    due.clear();
+    for (CombatNPC *npc : npcs) {
+        if (npc->kind != EntityKind::MOB)
+            continue;
+
+        // same conditions as the scan in roamingStep()
+        Mob *mob = (Mob*)npc;
+        if (mob->state != AIState::ROAMING || mob->playersInView <= 0
+            || (mob->nextAttack != 0 && currTime < mob->nextAttack))
+            continue;
+
+        due.push_back(mob);
+    }
+
+    auto plan = [currTime](size_t start, size_t end) {
+        for (size_t i = start; i < end; i++) {
+            due[i]->plannedTarget = findAggroTarget(due[i]);
+            due[i]->plannedAt = currTime;
+        }
+    };
+
+    if (workers == nullptr || due.size() < MIN_PARALLEL_PLANS)
+        plan(0, due.size());
+    else
+        workers->run(due.size(), plan);
+}
+
+/*
+ * Mobs stepped earlier in the tick might have killed the planned target
+ * since, in which case we look again. Mobs that weren't planned for (woken up
+ * mid-tick, for instance) just scan now.
+ */
+static CNSocket *takePlannedTarget(Mob *mob, time_t currTime) {
+    if (mob->plannedAt != currTime)
+        return findAggroTarget(mob);
+
+    mob->plannedAt = 0;
+    CNSocket *target = mob->plannedTarget;
+
+    if (target != nullptr) {
+        auto it = PlayerManager::players.find(target);
+        if (it == PlayerManager::players.end() || it->second->HP <= 0)
+            return findAggroTarget(mob);
+    }
+
+    return target;
 }
 
 static void dealCorruption(Mob *mob, std::vector<int> targetData, int skillID, int mobStyle) {
@@ -283,7 +489,7 @@ static void dealCorruption(Mob *mob, std::vector<int> targetData, int skillID, i
         int nanoStyle = Nanos::nanoStyle(plr->activeNano);
         if (nanoStyle == -1) { // no nano
             respdata[i].iHitFlag = HF_BIT_STYLE_TIE;
-            respdata[i].iDamage = Abilities::SkillTable[skillID].values[0][0] * PC_MAXHEALTH((int)mob->data["m_iNpcLevel"]) / 1500;
+            respdata[i].iDamage = Abilities::SkillTable[skillID].values[0][0] * PC_MAXHEALTH(mob->tmpl->level) / 1500;
         } else if (mobStyle == nanoStyle) {
             respdata[i].iHitFlag = HF_BIT_STYLE_TIE;
             respdata[i].iDamage = 0;
@@ -314,7 +520,7 @@ static void dealCorruption(Mob *mob, std::vector<int> targetData, int skillID, i
             Abilities::useNanoSkill(sock, &skill, *plr->getActiveNano(), { mob });
         } else {
             respdata[i].iHitFlag = HF_BIT_STYLE_LOSE;
-            respdata[i].iDamage = Abilities::SkillTable[skillID].values[0][0] * PC_MAXHEALTH((int)mob->data["m_iNpcLevel"]) / 1500;
+            respdata[i].iDamage = Abilities::SkillTable[skillID].values[0][0] * PC_MAXHEALTH(mob->tmpl->level) / 1500;
             respdata[i].iNanoStamina = plr->Nanos[plr->activeNano].iStamina -= 90;
             if (plr->Nanos[plr->activeNano].iStamina < 0) {
                 respdata[i].bNanoDeactive = 1;
@@ -341,7 +547,7 @@ static void useAbilities(Mob *mob, time_t currTime) {
     Player *plr = PlayerManager::getPlayer(mob->target);
 
     if (mob->skillStyle >= 0) { // corruption hit
-        int skillID = (int)mob->data["m_iCorruptionType"];
+        int skillID = mob->tmpl->corruptionType;
         std::vector<int> targetData = {1, plr->iID, 0, 0, 0};
         int temp = mob->skillStyle;
         mob->skillStyle = -3; // corruption cooldown
@@ -351,19 +557,15 @@ static void useAbilities(Mob *mob, time_t currTime) {
     }
 
     if (mob->skillStyle == -2) { // eruption hit
-        int skillID = (int)mob->data["m_iMegaType"];
+        int skillID = mob->tmpl->megaType;
         std::vector<ICombatant*> targets{};
 
         // find the players within range of eruption
         for (auto it = mob->viewableChunks.begin(); it != mob->viewableChunks.end(); it++) {
             Chunk* chunk = *it;
-            for (const EntityRef& ref : chunk->entities) {
-                // TODO: see aggroCheck()
-                if (ref.kind != EntityKind::PLAYER)
-                    continue;
-
-                CNSocket *s = ref.sock;
-                Player *plr = PlayerManager::getPlayer(s);
+            // TODO: see aggroCheck()
+            for (const ChunkEntity& other : chunk->players) {
+                Player *plr = (Player*)other.ent;
 
                 if (!plr->isAlive())
                     continue;
@@ -388,24 +590,24 @@ static void useAbilities(Mob *mob, time_t currTime) {
         return;
     }
 
-    int random = Rand::rand(2000) * 1000;
-    int prob1 = (int)mob->data["m_iActiveSkill1Prob"]; // active skill probability
-    int prob2 = (int)mob->data["m_iCorruptionTypeProb"]; // corruption probability
-    int prob3 = (int)mob->data["m_iMegaTypeProb"]; // eruption probability
+    int random = Rand::rand(2000, Rand::Stream::MOBS) * 1000;
+    int prob1 = mob->tmpl->activeSkill1Prob; // active skill probability
+    int prob2 = mob->tmpl->corruptionTypeProb; // corruption probability
+    int prob3 = mob->tmpl->megaTypeProb; // eruption probability
 
     if (random < prob1) { // active skill hit
-        int skillID = (int)mob->data["m_iActiveSkill1"];
+        int skillID = mob->tmpl->activeSkill1;
         SkillData* skill = &Abilities::SkillTable[skillID];
         int debuffID = Abilities::getCSTBFromST(skill->skillType);
         if(plr->hasBuff(debuffID))
             return; // prevent debuffing a player twice
         Abilities::useNPCSkill(mob->getRef(), skillID, { plr });
-        mob->nextAttack = currTime + (int)mob->data["m_iDelayTime"] * 100;
+        mob->nextAttack = currTime + mob->tmpl->delayTime * 100;
         return;
     }
 
     if (random < prob1 + prob2) { // corruption windup
-        int skillID = (int)mob->data["m_iCorruptionType"];
+        int skillID = mob->tmpl->corruptionType;
         INITSTRUCT(sP_FE2CL_NPC_SKILL_CORRUPTION_READY, pkt);
         pkt.iNPC_ID = mob->id;
         pkt.iSkillID = skillID;
@@ -416,7 +618,7 @@ static void useAbilities(Mob *mob, time_t currTime) {
         if (mob->skillStyle == -1)
             mob->skillStyle = 2;
         if (mob->skillStyle == -2)
-            mob->skillStyle = Rand::rand(3);
+            mob->skillStyle = Rand::rand(3, Rand::Stream::MOBS);
         pkt.iStyle = mob->skillStyle;
         NPCManager::sendToViewable(mob, &pkt, P_FE2CL_NPC_SKILL_CORRUPTION_READY, sizeof(sP_FE2CL_NPC_SKILL_CORRUPTION_READY));
         mob->nextAttack = currTime + 1800;
@@ -424,7 +626,7 @@ static void useAbilities(Mob *mob, time_t currTime) {
     }
 
     if (random < prob1 + prob2 + prob3) { // eruption windup
-        int skillID = (int)mob->data["m_iMegaType"];
+        int skillID = mob->tmpl->megaType;
         INITSTRUCT(sP_FE2CL_NPC_SKILL_READY, pkt);
         pkt.iNPC_ID = mob->id;
         pkt.iSkillID = skillID;
@@ -444,8 +646,8 @@ void MobAI::incNextMovement(Mob* mob, time_t currTime) {
     if (currTime == 0)
         currTime = getTime();
 
-    int delay = (int)mob->data["m_iDelayTime"] * 1000;
-    mob->nextMovement = currTime + delay / 2 + Rand::rand(delay / 2);
+    int delay = mob->tmpl->delayTime * 1000;
+    mob->nextMovement = currTime + delay / 2 + Rand::rand(delay / 2, Rand::Stream::MOBS);
 }
 
 void MobAI::deadStep(CombatNPC* npc, time_t currTime) {
@@ -552,10 +754,10 @@ void MobAI::combatStep(CombatNPC* npc, time_t currTime) {
     }
 
     int distance = hypot(plr->x - self->x, plr->y - self->y);
-    int mobRange = (int)self->data["m_iAtkRange"] + (int)self->data["m_iRadius"];
+    int mobRange = self->tmpl->atkRange + self->tmpl->radius;
 
     if (currTime >= self->nextAttack) {
-        if (self->skillStyle != -1 || distance <= mobRange || Rand::rand(20) == 0) // while not in attack range, 1 / 20 chance.
+        if (self->skillStyle != -1 || distance <= mobRange || Rand::rand(20, Rand::Stream::MOBS) == 0) // while not in attack range, 1 / 20 chance.
             useAbilities(self, currTime);
         if (self->target == nullptr)
             return;
@@ -608,7 +810,7 @@ void MobAI::combatStep(CombatNPC* npc, time_t currTime) {
      */
     if (distance <= mobRange || distanceToTravel < self->speed*2/5) {
         if (self->nextAttack == 0 || currTime >= self->nextAttack) {
-            self->nextAttack = currTime + (int)self->data["m_iDelayTime"] * 100;
+            self->nextAttack = currTime + self->tmpl->delayTime * 100;
             Combat::npcAttackPc(self, currTime);
         }
     }
@@ -616,7 +818,7 @@ void MobAI::combatStep(CombatNPC* npc, time_t currTime) {
     // retreat if the player leaves combat range
     int xyDistance = hypot(plr->x - self->roamX, plr->y - self->roamY);
     distance = hypot(xyDistance, plr->z - self->roamZ);
-    if (distance >= self->data["m_iCombatRange"]) {
+    if (distance >= self->tmpl->combatRange) {
         self->transition(AIState::RETREAT, self->target);
     }
 }
@@ -631,7 +833,7 @@ void MobAI::roamingStep(CombatNPC* npc, time_t currTime) {
      */
     if (self->state != AIState::DEAD && (self->nextAttack == 0 || currTime >= self->nextAttack)) {
         self->nextAttack = currTime + 500;
-        if (aggroCheck(self, currTime))
+        if (engage(self, takePlannedTarget(self, currTime)))
             return;
     }
 
@@ -662,8 +864,8 @@ void MobAI::roamingStep(CombatNPC* npc, time_t currTime) {
     int minDistance = self->idleRange / 2;
 
     // pick a random destination
-    farX = xStart + Rand::rand(self->idleRange);
-    farY = yStart + Rand::rand(self->idleRange);
+    farX = xStart + Rand::rand(self->idleRange, Rand::Stream::MOBS);
+    farY = yStart + Rand::rand(self->idleRange, Rand::Stream::MOBS);
 
     distance = std::abs(std::max(farX - self->x, farY - self->y));
     if (distance == 0)
@@ -681,13 +883,13 @@ void MobAI::roamingStep(CombatNPC* npc, time_t currTime) {
     if (self->hasBuff(ECSB_DN_MOVE_SPEED))
         self->speed /= 2;
 
-    std::queue<Vec3> queue;
+    std::vector<Vec3> points;
     Vec3 from = { self->x, self->y, self->z };
     Vec3 to = { farX, farY, self->z };
 
-    // add a route to the queue; to be processed in Transport::stepNPCPathing()
-    Transport::lerp(&queue, from, to, self->speed);
-    Transport::NPCQueues[self->id] = queue;
+    // set a route; to be processed in Transport::stepNPCPathing()
+    Transport::lerp(&points, from, to, self->speed);
+    Transport::NPCRoutes[self->id] = NPCRoute(std::move(points));
 
     if (self->groupLeader != 0 && self->groupLeader == self->id) {
         // make followers follow this npc.
@@ -700,12 +902,12 @@ void MobAI::roamingStep(CombatNPC* npc, time_t currTime) {
                 continue;
             }
 
-            std::queue<Vec3> queue2;
+            std::vector<Vec3> points2;
             Mob* followerMob = (Mob*)NPCManager::NPCs[self->groupMember[i]];
             from = { followerMob->x, followerMob->y, followerMob->z };
             to = { farX + followerMob->offsetX, farY + followerMob->offsetY, followerMob->z };
-            Transport::lerp(&queue2, from, to, self->speed);
-            Transport::NPCQueues[followerMob->id] = queue2;
+            Transport::lerp(&points2, from, to, self->speed);
+            Transport::NPCRoutes[followerMob->id] = NPCRoute(std::move(points2));
         }
     }
 }
@@ -721,7 +923,7 @@ void MobAI::retreatStep(CombatNPC* npc, time_t currTime) {
     // distance between spawn point and current location
     int distance = hypot(self->x - self->roamX, self->y - self->roamY);
 
-    //if (distance > mob->data["m_iIdleRange"]) {
+    //if (distance > mob->tmpl->idleRange) {
     if (distance > 10) {
         INITSTRUCT(sP_FE2CL_NPC_MOVE, pkt);
 
@@ -739,7 +941,7 @@ void MobAI::retreatStep(CombatNPC* npc, time_t currTime) {
     }
 
     // if we got there
-    //if (distance <= mob->data["m_iIdleRange"]) {
+    //if (distance <= mob->tmpl->idleRange) {
     if (distance <= 10) { // retreat back to the spawn point
         self->transition(AIState::ROAMING, self->id);
     }
@@ -771,7 +973,7 @@ void MobAI::onCombatStart(CombatNPC* npc, EntityRef src) {
     self->roamY = self->y;
     self->roamZ = self->z;
 
-    int skillID = (int)self->data["m_iPassiveBuff"];
+    int skillID = self->tmpl->passiveBuff;
     if(skillID != 0) // cast passive
         Abilities::useNPCSkill(npc->getRef(), skillID, { npc });
 }
@@ -830,11 +1032,11 @@ void MobAI::onDeath(CombatNPC* npc, EntityRef src) {
     // delay the despawn animation
     self->despawned = false;
 
-    auto it = Transport::NPCQueues.find(self->id);
-    if (it == Transport::NPCQueues.end() || it->second.empty())
+    auto it = Transport::NPCRoutes.find(self->id);
+    if (it == Transport::NPCRoutes.end() || it->second.empty())
         return;
 
-    // rewind or empty the movement queue
+    // rewind or drop the route
     if (self->staticPath) {
         /*
          * This is inelegant, but we wind forward in the path until we find the point that
@@ -842,13 +1044,11 @@ void MobAI::onDeath(CombatNPC* npc, EntityRef src) {
          *
          * IMPORTANT: The check in TableData::loadPaths() must pass or else this will loop forever.
          */
-        auto& queue = it->second;
-        for (auto point = queue.front(); point.x != self->spawnX || point.y != self->spawnY; point = queue.front()) {
-            queue.pop();
-            queue.push(point);
-        }
+        NPCRoute& route = it->second;
+        for (Vec3 point = route.front(); point.x != self->spawnX || point.y != self->spawnY; point = route.front())
+            route.advance(true);
     }
     else {
-        Transport::NPCQueues.erase(self->id);
+        Transport::NPCRoutes.erase(self->id);
     }
 }
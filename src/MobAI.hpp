@@ -7,6 +7,7 @@
 
 #include <unordered_map>
 #include <string>
+#include <vector>
 
 namespace MobAI {
     void deadStep(CombatNPC* self, time_t currTime);
@@ -20,6 +21,33 @@ namespace MobAI {
     void onDeath(CombatNPC* self, EntityRef src);
 }
 
+/*
+ * The stats of an NPC type that mobs need, parsed out of its entry in
+ * NPCManager::NPCData once at load time and shared by every mob of that type.
+ */
+struct MobTemplate {
+    int hp = 0;
+    int level = 0;
+    int sightRange = 0;
+    int idleRange = 0;
+    int combatRange = 0;
+    int runSpeed = 0;
+    int regenTime = 0;
+    int delayTime = 0;
+    int atkRange = 0;
+    int radius = 0;
+    int power = 0;
+    int protection = 0;
+    int npcStyle = 0;
+    int activeSkill1 = 0;
+    int activeSkill1Prob = 0;
+    int corruptionType = 0;
+    int corruptionTypeProb = 0;
+    int megaType = 0;
+    int megaTypeProb = 0;
+    int passiveBuff = 0;
+};
+
 struct Mob : public CombatNPC {
 
     // dead
@@ -34,6 +62,9 @@ struct Mob : public CombatNPC {
     time_t nextMovement = 0;
     bool staticPath = false;
     int roamX = 0, roamY = 0, roamZ = 0;
+    // aggro target picked by MobAI::planAggro() for the tick at plannedAt
+    CNSocket *plannedTarget = nullptr;
+    time_t plannedAt = 0;
 
     // combat
     CNSocket *target = nullptr;
@@ -47,20 +78,17 @@ struct Mob : public CombatNPC {
     int offsetX = 0, offsetY = 0;
     int groupMember[4] = {};
 
-    // temporary; until we're sure what's what
-    nlohmann::json data = {};
+    const MobTemplate *tmpl;
 
-    Mob(int spawnX, int spawnY, int spawnZ, int angle, uint64_t iID, int t, nlohmann::json d, int32_t id)
-        : CombatNPC(spawnX, spawnY, spawnZ, angle, iID, t, id, d["m_iHP"]),
-          sightRange(d["m_iSightRange"]) {
+    Mob(int spawnX, int spawnY, int spawnZ, int angle, uint64_t iID, int t, const MobTemplate *mt, int32_t id)
+        : CombatNPC(spawnX, spawnY, spawnZ, angle, iID, t, id, mt->hp),
+          sightRange(mt->sightRange), tmpl(mt) {
         state = AIState::ROAMING;
 
-        data = d;
-
-        speed = data["m_iRunSpeed"];
-        regenTime = data["m_iRegenTime"];
-        idleRange = (int)data["m_iIdleRange"];
-        level = data["m_iNpcLevel"];
+        speed = tmpl->runSpeed;
+        regenTime = tmpl->regenTime;
+        idleRange = tmpl->idleRange;
+        level = tmpl->level;
 
         roamX = spawnX;
         roamY = spawnY;
@@ -87,8 +115,8 @@ struct Mob : public CombatNPC {
     }
 
     // constructor for /summon
-    Mob(int x, int y, int z, uint64_t iID, int t, nlohmann::json d, int32_t id)
-        : Mob(x, y, z, 0, iID, t, d, id) {
+    Mob(int x, int y, int z, uint64_t iID, int t, const MobTemplate *mt, int32_t id)
+        : Mob(x, y, z, 0, iID, t, mt, id) {
         summoned = true; // will be despawned and deallocated when killed
     }
 
@@ -97,13 +125,19 @@ struct Mob : public CombatNPC {
     virtual int takeDamage(EntityRef src, int amt) override;
     virtual void step(time_t currTime) override;
 
-    auto operator[](std::string s) {
-        return data[s];
+    // dead and retreating mobs keep going even without anyone watching
+    virtual bool isActive() override {
+        return playersInView > 0 || state == AIState::DEAD || state == AIState::RETREAT;
     }
 };
 
 namespace MobAI {
     extern bool simulateMobs;
+    extern std::vector<MobTemplate> Templates; // indexed by NPC type
+
+    void loadTemplates();
+    void startWorkers(int count);
+    void planAggro(const std::vector<CombatNPC*>& npcs, time_t currTime);
 
     // TODO: make this internal later
     void incNextMovement(Mob *mob, time_t currTime=0);
@@ -33,6 +33,14 @@ nlohmann::json NPCManager::NPCData;
 
 static std::queue<int32_t> RemovalQueue;
 
+/*
+ * The combat NPCs that step() has to tick, so that it doesn't have to go
+ * through every NPC in the world. NPCs are added by wakeNPC() as soon as they
+ * become active, and dropped by step() once they no longer are. Each NPC knows
+ * its own position in here (CombatNPC::activeIndex).
+ */
+static std::vector<CombatNPC*> ActiveNPCs;
+
 /*
  * Initialized at the end of TableData::init().
  * This allows us to summon and kill mobs in arbitrary order without
@@ -40,6 +48,29 @@ static std::queue<int32_t> RemovalQueue;
  */
 int32_t NPCManager::nextId;
 
+static void removeActive(CombatNPC *npc) {
+    int i = npc->activeIndex;
+    if (i < 0)
+        return;
+
+    ActiveNPCs[i] = ActiveNPCs.back();
+    ActiveNPCs[i]->activeIndex = i;
+    ActiveNPCs.pop_back();
+    npc->activeIndex = -1;
+}
+
+/*
+ * Starts stepping an NPC if its isActive() says it should be.
+ * Call whenever something that might make it active changes.
+ */
+void NPCManager::wakeNPC(CombatNPC *npc) {
+    if (npc->activeIndex >= 0 || !npc->isActive())
+        return;
+
+    npc->activeIndex = ActiveNPCs.size();
+    ActiveNPCs.push_back(npc);
+}
+
 void NPCManager::destroyNPC(int32_t id) {
     // sanity check
     if (NPCs.find(id) == NPCs.end()) {
@@ -55,6 +86,10 @@ void NPCManager::destroyNPC(int32_t id) {
         return;
     }
 
+    // stop stepping it
+    if (entity->kind == EntityKind::COMBAT_NPC || entity->kind == EntityKind::MOB)
+        removeActive((CombatNPC*)entity);
+
     // remove NPC from the chunk
     EntityRef ref = {id};
     Chunking::untrackEntity(entity->chunkPos, ref);
@@ -84,10 +119,8 @@ void NPCManager::updateNPCPosition(int32_t id, int X, int Y, int Z, uint64_t I,
 void NPCManager::sendToViewable(Entity *npc, void *buf, uint32_t type, size_t size) {
     for (auto it = npc->viewableChunks.begin(); it != npc->viewableChunks.end(); it++) {
         Chunk* chunk = *it;
-        for (const EntityRef& ref : chunk->entities) {
-            if (ref.kind == EntityKind::PLAYER)
-                ref.sock->sendPacket(buf, type, size);
-        }
+        for (const ChunkEntity& other : chunk->players)
+            other.ref.sock->sendPacket(buf, type, size);
     }
 }
 
@@ -109,11 +142,11 @@ static void npcBarkHandler(CNSocket* sock, CNPacketData* data) {
     std::vector<std::pair<int32_t, int32_t>> npcLines;
 
     for (Chunk* chunk : plr->viewableChunks) {
-        for (auto ent = chunk->entities.begin(); ent != chunk->entities.end(); ent++) {
-            if (ent->kind != EntityKind::SIMPLE_NPC)
+        for (const ChunkEntity& other : chunk->npcs) {
+            if (other.ref.kind != EntityKind::SIMPLE_NPC)
                 continue;
 
-            BaseNPC* npc = (BaseNPC*)ent->getEntity();
+            BaseNPC* npc = (BaseNPC*)other.ent;
             if (npc->type < 0 || npc->type >= NPCData.size())
                 continue; // npc unknown ?!
 
@@ -159,7 +192,7 @@ BaseNPC *NPCManager::summonNPC(int spawnX, int spawnY, int spawnZ, uint64_t inst
     BaseNPC *npc = nullptr;
 
     if (team == 2) {
-        npc = new Mob(spawnX, spawnY, spawnZ, inst, type, NPCData[type], id);
+        npc = new Mob(spawnX, spawnY, spawnZ, inst, type, &MobAI::Templates[type], id);
 
         // re-enable respawning, if desired
         ((Mob*)npc)->summoned = !respawn;
@@ -301,16 +334,13 @@ static void npcWarpTimeMachine(CNSocket* sock, CNPacketData* data) {
 /*
  * Helper function to get NPC closest to coordinates in specified chunks
  */
-BaseNPC* NPCManager::getNearestNPC(std::set<Chunk*>* chunks, int X, int Y, int Z) {
+BaseNPC* NPCManager::getNearestNPC(ChunkSet* chunks, int X, int Y, int Z) {
     BaseNPC* npc = nullptr;
     int lastDist = INT_MAX;
     for (auto c = chunks->begin(); c != chunks->end(); c++) { // haha get it
         Chunk* chunk = *c;
-        for (auto ent = chunk->entities.begin(); ent != chunk->entities.end(); ent++) {
-            if (ent->kind == EntityKind::PLAYER)
-                continue;
-
-            BaseNPC* npcTemp = (BaseNPC*)ent->getEntity();
+        for (const ChunkEntity& other : chunk->npcs) {
+            BaseNPC* npcTemp = (BaseNPC*)other.ent;
             int distXY = std::hypot(X - npcTemp->x, Y - npcTemp->y);
             int dist = std::hypot(distXY, Z - npcTemp->z);
             if (dist < lastDist) {
@@ -380,12 +410,26 @@ void NPCManager::queueNPCRemoval(int32_t id) {
 }
 
 static void step(CNServer *serv, time_t currTime) {
-    for (auto& pair : NPCs) {
-        if (pair.second->kind != EntityKind::COMBAT_NPC && pair.second->kind != EntityKind::MOB)
+    MobAI::planAggro(ActiveNPCs, currTime);
+
+    /*
+     * NPCs may be woken up or destroyed while we're stepping others.
+     * Whenever the current slot gets swapped out from under us, it now holds
+     * one we haven't stepped yet, so don't advance.
+     */
+    for (size_t i = 0; i < ActiveNPCs.size();) {
+        CombatNPC *npc = ActiveNPCs[i];
+
+        // went idle since the last tick
+        if (!npc->isActive()) {
+            removeActive(npc);
             continue;
-        auto npc = (CombatNPC*)pair.second;
+        }
 
         npc->step(currTime);
+
+        if (i < ActiveNPCs.size() && ActiveNPCs[i] == npc)
+            i++;
     }
 
     // deallocate all NPCs queued for removal
@@ -403,4 +447,7 @@ void NPCManager::init() {
     REGISTER_SHARD_PACKET(P_CL2FE_REQ_BARKER, npcBarkHandler);
 
     REGISTER_SHARD_TIMER(step, MS_PER_COMBAT_TICK);
+
+    // must happen before the sandbox is engaged
+    MobAI::startWorkers(settings::AITHREADS);
 }
@@ -35,6 +35,7 @@ namespace NPCManager {
     void init();
 
     void queueNPCRemoval(int32_t);
+    void wakeNPC(CombatNPC *npc);
     void destroyNPC(int32_t);
     void updateNPCPosition(int32_t, int X, int Y, int Z, uint64_t I, int angle);
 
@@ -42,5 +43,5 @@ namespace NPCManager {
 
     BaseNPC *summonNPC(int x, int y, int z, uint64_t instance, int type, bool respawn=false, bool baseInstance=false);
 
-    BaseNPC* getNearestNPC(std::set<Chunk*>* chunks, int X, int Y, int Z);
+    BaseNPC* getNearestNPC(ChunkSet* chunks, int X, int Y, int Z);
 }
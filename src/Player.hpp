@@ -52,6 +52,13 @@ struct Player : public Entity, public ICombatant {
 
     bool inCombat = false;
     bool onMonkey = false;
+
+    // movement replication when dead reckoning is enabled; see PlayerMovement.cpp
+    sP_FE2CL_PC_MOVE lastMove = {}; // latest one received
+    sP_FE2CL_PC_MOVE sentMove = {}; // latest one broadcast
+    bool movePending = false;
+    time_t sentMoveTime = 0; // 0 forces the next move out
+    int staleRanges = 0; // viewer distance ranges that haven't been sent sentMove yet
     int healCooldown = 0;
 
     int pointDamage = 0;
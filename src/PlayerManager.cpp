@@ -81,8 +81,11 @@ void PlayerManager::updatePlayerPosition(CNSocket* sock, int X, int Y, int Z, ui
         plr->instanceID = I;
         plr->recallInstance = INSTANCE_OVERWORLD;
     }
-    if (oldChunk == newChunk)
-        return; // didn't change chunks
+    if (oldChunk == newChunk) {
+        // didn't change chunks
+        Chunking::updatePlayerPos({sock});
+        return;
+    }
     Chunking::updateEntityChunk({sock}, oldChunk, newChunk);
 }
 
@@ -335,11 +338,11 @@ void PlayerManager::sendToViewable(CNSocket* sock, void* buf, uint32_t type, siz
     Player* plr = getPlayer(sock);
     for (auto it = plr->viewableChunks.begin(); it != plr->viewableChunks.end(); it++) {
         Chunk* chunk = *it;
-        for (const EntityRef& ref : chunk->entities) {
-            if (ref.kind != EntityKind::PLAYER || ref.sock == sock)
+        for (const ChunkEntity& other : chunk->players) {
+            if (other.ref.sock == sock)
                 continue;
 
-            ref.sock->sendPacket(buf, type, size);
+            other.ref.sock->sendPacket(buf, type, size);
         }
     }
 }
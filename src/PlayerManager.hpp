@@ -42,11 +42,11 @@ namespace PlayerManager {
         Player* plr = getPlayer(sock);
         for (auto it = plr->viewableChunks.begin(); it != plr->viewableChunks.end(); it++) {
             Chunk* chunk = *it;
-            for (const EntityRef& ref : chunk->entities) {
-                if (ref.kind != EntityKind::PLAYER || ref.sock == sock)
+            for (const ChunkEntity& other : chunk->players) {
+                if (other.ref.sock == sock)
                     continue;
 
-                ref.sock->sendPacket(pkt, type);
+                other.ref.sock->sendPacket(pkt, type);
             }
         }
     }
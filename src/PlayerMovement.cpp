@@ -4,8 +4,113 @@
 
 #include "PlayerManager.hpp"
 #include "TableData.hpp"
+#include "Chunking.hpp"
+#include "settings.hpp"
 #include "core/Core.hpp"
 
+PlayerMovement::MoveStats PlayerMovement::stats = {};
+
+/*
+ * Dead reckoning.
+ *
+ * Instead of relaying every P_CL2FE_REQ_PC_MOVE to everyone in view, only the
+ * latest move of each player is kept, and flushMoves() sends it out every
+ * MOVE_FLUSH_INTERVAL ms. Clients extrapolate other players' positions from
+ * the velocity in the last move they got, so nothing is sent while a player
+ * keeps moving the same way, save for a refresh every MOVE_KEYFRAME_INTERVAL ms.
+ *
+ * Viewers are sorted into three distance ranges, which get a new motion on
+ * every flush, every second flush and every fourth flush respectively. They
+ * are always sent the latest move, so further away viewers see the same path,
+ * just coarser.
+ */
+#define MOVE_FLUSH_INTERVAL 100
+#define MOVE_KEYFRAME_INTERVAL 1000
+#define ALL_RANGES 0b111
+
+// how many others can see this player
+static int countViewers(Player *plr) {
+    int count = 0;
+    for (Chunk *chunk : plr->viewableChunks)
+        count += chunk->players.size();
+
+    return count > 0 ? count - 1 : 0; // not counting themselves
+}
+
+static bool sameMotion(sP_FE2CL_PC_MOVE& a, sP_FE2CL_PC_MOVE& b) {
+    return a.fVX == b.fVX && a.fVY == b.fVY && a.fVZ == b.fVZ && a.iAngle == b.iAngle
+        && a.iSpeed == b.iSpeed && a.cKeyValue == b.cKeyValue;
+}
+
+// as a bit in ALL_RANGES
+static int viewerRange(Player *plr, Entity *viewer) {
+    int64_t dx = plr->x - viewer->x;
+    int64_t dy = plr->y - viewer->y;
+    int64_t distance = dx * dx + dy * dy;
+    int64_t near = settings::VIEWDISTANCE / 2;
+
+    if (distance < near * near)
+        return 0b001;
+    if (distance < (int64_t)settings::VIEWDISTANCE * settings::VIEWDISTANCE)
+        return 0b010;
+    return 0b100;
+}
+
+/*
+ * Any other kind of movement supersedes a pending move, and viewers need to be
+ * told as soon as the player goes back to moving normally afterwards.
+ */
+static void interruptMove(Player *plr) {
+    plr->movePending = false;
+    plr->staleRanges = 0;
+    plr->sentMoveTime = 0;
+}
+
+static void flushMoves(CNServer *serv, time_t currTime) {
+    static uint32_t flushes = 0;
+    flushes++;
+
+    int dueRanges = 0b001;
+    if (flushes % 2 == 0)
+        dueRanges |= 0b010;
+    if (flushes % 4 == 0)
+        dueRanges |= 0b100;
+
+    for (auto& pair : PlayerManager::players) {
+        CNSocket *sock = pair.first;
+        Player *plr = pair.second;
+
+        if (plr->movePending) {
+            plr->movePending = false;
+
+            if (currTime - plr->sentMoveTime >= MOVE_KEYFRAME_INTERVAL || !sameMotion(plr->lastMove, plr->sentMove)) {
+                plr->sentMove = plr->lastMove;
+                plr->sentMoveTime = currTime;
+                plr->staleRanges = ALL_RANGES;
+            }
+        }
+
+        int ranges = plr->staleRanges & dueRanges;
+        if (ranges == 0)
+            continue;
+        plr->staleRanges &= ~ranges;
+
+        // the position is as fresh as it gets, even if the motion was decided earlier
+        sP_FE2CL_PC_MOVE& move = plr->lastMove;
+        move.iSvrTime = getTime();
+
+        for (Chunk *chunk : plr->viewableChunks) {
+            for (const ChunkEntity& other : chunk->players) {
+                if (other.ref.sock == sock || !(viewerRange(plr, other.ent) & ranges))
+                    continue;
+
+                other.ref.sock->sendPacket(move, P_FE2CL_PC_MOVE);
+                PlayerMovement::stats.sent++;
+            }
+        }
+    }
+}
+
 static void movePlayer(CNSocket* sock, CNPacketData* data) {
     Player* plr = PlayerManager::getPlayer(sock);
 
@@ -31,13 +136,23 @@ static void movePlayer(CNSocket* sock, CNPacketData* data) {
     moveResponse.iCliTime = moveData->iCliTime; // maybe don't send this??? seems unneeded...
     moveResponse.iSvrTime = tm;
 
-    PlayerManager::sendToViewable(sock, moveResponse, P_FE2CL_PC_MOVE);
+    int viewers = countViewers(plr);
+    PlayerMovement::stats.full += viewers;
+
+    if (settings::DEADRECKONING) {
+        // sent out by flushMoves()
+        plr->lastMove = moveResponse;
+        plr->movePending = true;
+    } else {
+        PlayerManager::sendToViewable(sock, moveResponse, P_FE2CL_PC_MOVE);
+        PlayerMovement::stats.sent += viewers;
+    }
 
     // [gruntwork] check if player has a follower and move it
     if (TableData::RunningNPCPaths.find(plr->iID) != TableData::RunningNPCPaths.end()) {
         BaseNPC* follower = TableData::RunningNPCPaths[plr->iID].first;
-        Transport::NPCQueues.erase(follower->id); // erase existing points
-        std::queue<Vec3> queue;
+        Transport::NPCRoutes.erase(follower->id); // erase existing points
+        std::vector<Vec3> points;
         Vec3 from = { follower->x, follower->y, follower->z };
         float drag = 0.95f; // this ensures that they don't bump into the player
         Vec3 to = {
@@ -46,9 +161,9 @@ static void movePlayer(CNSocket* sock, CNPacketData* data) {
             (int)(follower->z + (moveData->iZ - follower->z) * drag)
         };
 
-        // add a route to the queue; to be processed in Transport::stepNPCPathing()
-        Transport::lerp(&queue, from, to, NPC_DEFAULT_SPEED * 1.5); // little faster than typical
-        Transport::NPCQueues[follower->id] = queue;
+        // set a route; to be processed in Transport::stepNPCPathing()
+        Transport::lerp(&points, from, to, NPC_DEFAULT_SPEED * 1.5); // little faster than typical
+        Transport::NPCRoutes[follower->id] = NPCRoute(std::move(points));
     }
 }
 
@@ -71,6 +186,7 @@ static void stopPlayer(CNSocket* sock, CNPacketData* data) {
     stopResponse.iCliTime = stopData->iCliTime; // maybe don't send this??? seems unneeded...
     stopResponse.iSvrTime = tm;
 
+    interruptMove(plr);
     PlayerManager::sendToViewable(sock, stopResponse, P_FE2CL_PC_STOP);
 }
 
@@ -99,6 +215,7 @@ static void jumpPlayer(CNSocket* sock, CNPacketData* data) {
     jumpResponse.iCliTime = jumpData->iCliTime; // maybe don't send this??? seems unneeded...
     jumpResponse.iSvrTime = tm;
 
+    interruptMove(plr);
     PlayerManager::sendToViewable(sock, jumpResponse, P_FE2CL_PC_JUMP);
 }
 
@@ -125,6 +242,7 @@ static void jumppadPlayer(CNSocket* sock, CNPacketData* data) {
     jumppadResponse.iCliTime = jumppadData->iCliTime;
     jumppadResponse.iSvrTime = tm;
 
+    interruptMove(plr);
     PlayerManager::sendToViewable(sock, jumppadResponse, P_FE2CL_PC_JUMPPAD);
 }
 
@@ -152,6 +270,7 @@ static void launchPlayer(CNSocket* sock, CNPacketData* data) {
     launchResponse.iCliTime = launchData->iCliTime;
     launchResponse.iSvrTime = tm;
 
+    interruptMove(plr);
     PlayerManager::sendToViewable(sock, launchResponse, P_FE2CL_PC_LAUNCHER);
 }
 
@@ -186,6 +305,7 @@ static void ziplinePlayer(CNSocket* sock, CNPacketData* data) {
     ziplineResponse.iRollMax = ziplineData->iRollMax;
     ziplineResponse.iRoll = ziplineData->iRoll;
 
+    interruptMove(plr);
     PlayerManager::sendToViewable(sock, ziplineResponse, P_FE2CL_PC_ZIPLINE);
 }
 
@@ -217,6 +337,7 @@ static void movePlatformPlayer(CNSocket* sock, CNPacketData* data) {
     platResponse.cKeyValue = platformData->cKeyValue;
     platResponse.iPlatformID = platformData->iPlatformID;
 
+    interruptMove(plr);
     PlayerManager::sendToViewable(sock, platResponse, P_FE2CL_PC_MOVEPLATFORM);
 }
 
@@ -247,6 +368,7 @@ static void moveSliderPlayer(CNSocket* sock, CNPacketData* data) {
     sliderResponse.cKeyValue = sliderData->cKeyValue;
     sliderResponse.iT_ID = sliderData->iT_ID;
 
+    interruptMove(plr);
     PlayerManager::sendToViewable(sock, sliderResponse, P_FE2CL_PC_MOVETRANSPORTATION);
 }
 
@@ -274,10 +396,14 @@ static void moveSlopePlayer(CNSocket* sock, CNPacketData* data) {
     slopeResponse.cKeyValue = slopeData->cKeyValue;
     slopeResponse.iSlopeID = slopeData->iSlopeID;
 
+    interruptMove(plr);
     PlayerManager::sendToViewable(sock, slopeResponse, P_FE2CL_PC_SLOPE);
 }
 
 void PlayerMovement::init() {
+    if (settings::DEADRECKONING)
+        REGISTER_SHARD_TIMER(flushMoves, MOVE_FLUSH_INTERVAL);
+
     REGISTER_SHARD_PACKET(P_CL2FE_REQ_PC_MOVE, movePlayer);
     REGISTER_SHARD_PACKET(P_CL2FE_REQ_PC_STOP, stopPlayer);
     REGISTER_SHARD_PACKET(P_CL2FE_REQ_PC_JUMP, jumpPlayer);
@@ -1,5 +1,15 @@
 #pragma once
 
+#include <stdint.h>
+
 namespace PlayerMovement {
+    // P_FE2CL_PC_MOVE packets, counted once per viewer
+    struct MoveStats {
+        uint64_t full; // if every move had been relayed to every viewer
+        uint64_t sent;
+    };
+
+    extern MoveStats stats;
+
     void init();
 };
@@ -1,37 +1,200 @@
 #include "Rand.hpp"
 #include "core/Core.hpp"
 
-std::unique_ptr<std::mt19937> Rand::generator;
+static Rand::Generator streams[(int)Rand::Stream::COUNT];
 
-int32_t Rand::rand(int32_t startInclusive, int32_t endExclusive) {
-    std::uniform_int_distribution<int32_t> dist(startInclusive, endExclusive - 1);
-    return dist(*Rand::generator);
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
 }
 
-int32_t Rand::rand(int32_t endExclusive) {
-    return Rand::rand(0, endExclusive);
+// splitmix64, to spread the seed over the whole state
+void Rand::Generator::reseed(uint64_t seed) {
+    for (int i = 0; i < 4; i++) {
+        uint64_t z = (seed += 0x9e3779b97f4a7c15);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        state[i] = z ^ (z >> 31);
+    }
+}
+
+uint64_t Rand::Generator::next() {
+    uint64_t result = rotl(state[1] * 5, 7) * 9;
+    uint64_t t = state[1] << 17;
+
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotl(state[3], 45);
+
+    return result;
+}
+
+void Rand::Generator::jump() {
+    static const uint64_t JUMP[] = { 0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c };
+    uint64_t jumped[4] = {};
+
+    for (uint64_t bits : JUMP) {
+        for (int b = 0; b < 64; b++) {
+            if (bits & ((uint64_t)1 << b))
+                for (int i = 0; i < 4; i++)
+                    jumped[i] ^= state[i];
+            next();
+        }
+    }
+
+    for (int i = 0; i < 4; i++)
+        state[i] = jumped[i];
+}
+
+/*
+ * Lemire's multiply-and-shift, which only needs a division in the rare case
+ * that the draw lands in the biased part of the range.
+ */
+uint32_t Rand::Generator::below(uint32_t bound) {
+    if (bound == 0)
+        return 0;
+
+    uint64_t m = (next() >> 32) * bound;
+    if ((uint32_t)m < bound) {
+        uint32_t threshold = -bound % bound;
+        while ((uint32_t)m < threshold)
+            m = (next() >> 32) * bound;
+    }
+
+    return m >> 32;
 }
 
-int32_t Rand::rand() {
-    return Rand::rand(0, INT32_MAX);
+uint64_t Rand::Generator::below64(uint64_t bound) {
+    if (bound == 0)
+        return 0;
+
+    // reject the low values that would make some results more likely than others
+    uint64_t threshold = -bound % bound;
+    uint64_t r;
+    do {
+        r = next();
+    } while (r < threshold);
+
+    return r % bound;
 }
 
-int32_t Rand::randWeighted(const std::vector<int32_t>& weights) {
-    std::discrete_distribution<int32_t> dist(weights.begin(), weights.end());
-    return dist(*Rand::generator);
+void Rand::init(uint64_t seed) {
+    for (int i = 0; i < (int)Stream::COUNT; i++)
+        Rand::seed((Stream)i, seed);
 }
 
-float Rand::randFloat(float startInclusive, float endExclusive) {
-    std::uniform_real_distribution<float> dist(startInclusive, endExclusive);
-    return dist(*Rand::generator);
+// each stream starts a jump further into the same sequence, so they never overlap
+void Rand::seed(Stream stream, uint64_t seed) {
+    Generator gen(seed);
+    for (int i = 0; i < (int)stream; i++)
+        gen.jump();
+
+    streams[(int)stream] = gen;
 }
 
-float Rand::randFloat(float endExclusive) {
-    return Rand::randFloat(0.0f, endExclusive);
+Rand::Generator& Rand::generator(Stream stream) {
+    return streams[(int)stream];
 }
 
-float Rand::randFloat() {
-    return Rand::randFloat(0.0f, 1.0f);
+int32_t Rand::rand(int32_t startInclusive, int32_t endExclusive, Stream stream) {
+    uint32_t range = endExclusive > startInclusive ? (uint32_t)((int64_t)endExclusive - startInclusive) : 0;
+    return (int32_t)(startInclusive + (int64_t)streams[(int)stream].below(range));
+}
+
+int32_t Rand::rand(int32_t endExclusive, Stream stream) {
+    return Rand::rand(0, endExclusive, stream);
+}
+
+int32_t Rand::rand(Stream stream) {
+    return Rand::rand(0, INT32_MAX, stream);
+}
+
+int32_t Rand::randWeighted(const std::vector<int32_t>& weights, Stream stream) {
+    uint64_t total = 0;
+    for (int32_t weight : weights)
+        total += std::max(weight, 0);
+
+    if (total == 0)
+        return 0;
+
+    uint64_t rolled = streams[(int)stream].below64(total);
+    for (size_t i = 0; i < weights.size(); i++) {
+        uint64_t weight = std::max(weights[i], 0);
+        if (rolled < weight)
+            return i;
+        rolled -= weight;
+    }
+
+    return 0; // not reached
+}
+
+Rand::WeightedTable::WeightedTable() : total(1), cutoffs(1, 1), aliases(1, 0) {}
+
+/*
+ * Each weight is scaled by the number of columns, so that every column holds
+ * exactly the total weight. Then the weight of a light index is topped up
+ * with part of a heavy one, which becomes its alias. Everything stays integer,
+ * so the odds come out exactly the same as with the weights themselves.
+ */
+Rand::WeightedTable::WeightedTable(const std::vector<int32_t>& weights) : WeightedTable() {
+    uint64_t sum = 0;
+    for (int32_t weight : weights)
+        sum += std::max(weight, 0);
+
+    if (sum == 0)
+        return;
+
+    size_t n = weights.size();
+    total = sum;
+    cutoffs.assign(n, sum);
+    aliases.resize(n);
+
+    std::vector<uint64_t> scaled(n);
+    std::vector<int32_t> light, heavy;
+    for (size_t i = 0; i < n; i++) {
+        scaled[i] = (uint64_t)std::max(weights[i], 0) * n;
+        aliases[i] = i;
+        (scaled[i] < sum ? light : heavy).push_back(i);
+    }
+
+    while (!light.empty() && !heavy.empty()) {
+        int32_t small = light.back(), large = heavy.back();
+        light.pop_back();
+
+        cutoffs[small] = scaled[small];
+        aliases[small] = large;
+
+        scaled[large] -= sum - scaled[small];
+        if (scaled[large] < sum) {
+            heavy.pop_back();
+            light.push_back(large);
+        }
+    }
+    // whatever's left fills its own column exactly
+}
+
+int32_t Rand::randWeighted(const WeightedTable& table, Stream stream) {
+    // one draw picks both the column and the spot within it
+    uint64_t rolled = streams[(int)stream].below64(table.cutoffs.size() * table.total);
+
+    size_t column = rolled / table.total;
+    return (rolled % table.total < table.cutoffs[column]) ? column : table.aliases[column];
+}
+
+float Rand::randFloat(float startInclusive, float endExclusive, Stream stream) {
+    // the top 24 bits, which is all a float can hold
+    float unit = (streams[(int)stream].next() >> 40) * (1.0f / 16777216.0f);
+    return startInclusive + unit * (endExclusive - startInclusive);
+}
+
+float Rand::randFloat(float endExclusive, Stream stream) {
+    return Rand::randFloat(0.0f, endExclusive, stream);
+}
+
+float Rand::randFloat(Stream stream) {
+    return Rand::randFloat(0.0f, 1.0f, stream);
 }
 
 #define RANDBYTES 8
@@ -85,7 +248,3 @@ fail:
     /* not reached */
     return 0;
 }
-
-void Rand::init(uint64_t seed) {
-    Rand::generator = std::make_unique<std::mt19937>(std::mt19937(seed));
-}
@@ -1,23 +1,82 @@
 #pragma once
 
-#include <random>
-#include <memory>
+#include <stdint.h>
+#include <limits>
 #include <vector>
 
 namespace Rand {
-    extern std::unique_ptr<std::mt19937> generator;
+    /*
+     * xoshiro256**: small, fast and plenty good for gameplay, but not fit for
+     * anything that has to be unpredictable; use cryptoRand() for that.
+     * It can also be handed to the <random> distributions.
+     */
+    class Generator {
+    private:
+        uint64_t state[4];
 
+    public:
+        typedef uint64_t result_type;
+
+        Generator(uint64_t seed = 0) { reseed(seed); }
+        void reseed(uint64_t seed);
+
+        uint64_t next();
+        // skips ahead 2^128 draws, so that sequences started from one seed never overlap
+        void jump();
+
+        // unbiased, in [0, bound); 0 when bound is 0
+        uint32_t below(uint32_t bound);
+        uint64_t below64(uint64_t bound);
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+        result_type operator()() { return next(); }
+    };
+
+    /*
+     * Independent sequences for each subsystem, so that, say, mobs wandering
+     * around doesn't change which drops the players get. They all live on the
+     * shard thread; anything running elsewhere should keep its own Generator.
+     */
+    enum class Stream {
+        MISC,
+        DROPS,
+        COMBAT,
+        MOBS,
+        COUNT
+    };
+
+    // with the same seed, every stream repeats the same sequence
     void init(uint64_t seed);
+    void seed(Stream stream, uint64_t seed);
+    Generator& generator(Stream stream);
+
+    // an empty range gives startInclusive
+    int32_t rand(int32_t startInclusive, int32_t endExclusive, Stream stream = Stream::MISC);
+    int32_t rand(int32_t endExclusive, Stream stream = Stream::MISC);
+    int32_t rand(Stream stream = Stream::MISC);
+
+    int32_t randWeighted(const std::vector<int32_t>& weights, Stream stream = Stream::MISC);
+
+    /*
+     * A set of weights prepared for repeated draws with Walker's alias method.
+     * Building one is O(n), but each draw from it is O(1) and never allocates.
+     * Like randWeighted(), all zero or no weights always draw index 0.
+     */
+    struct WeightedTable {
+        uint64_t total; // sum of the weights; every column holds this much
+        std::vector<uint64_t> cutoffs; // below this, a column draws itself
+        std::vector<int32_t> aliases; // and at or above it, this index
 
-    int32_t rand(int32_t startInclusive, int32_t endExclusive);
-    int32_t rand(int32_t endExclusive);
-    int32_t rand();
+        WeightedTable();
+        WeightedTable(const std::vector<int32_t>& weights);
+    };
 
-    int32_t randWeighted(const std::vector<int32_t>& weights);
+    int32_t randWeighted(const WeightedTable& table, Stream stream = Stream::MISC);
 
     uint64_t cryptoRand();
 
-    float randFloat(float startInclusive, float endExclusive);
-    float randFloat(float endExclusive);
-    float randFloat();
+    float randFloat(float startInclusive, float endExclusive, Stream stream = Stream::MISC);
+    float randFloat(float endExclusive, Stream stream = Stream::MISC);
+    float randFloat(Stream stream = Stream::MISC);
 };
@@ -8,6 +8,7 @@
 #include "Nanos.hpp"
 #include "Abilities.hpp"
 #include "Eggs.hpp"
+#include "MobAI.hpp"
 
 #include <fstream>
 #include <sstream>
@@ -77,6 +78,7 @@ static void constructPathSkyway(json& pathData) {
 static void loadXDT(json& xdtData) {
     // data we'll need for summoned mobs
     NPCManager::NPCData = xdtData["m_pNpcTable"]["m_pNpcData"];
+    MobAI::loadTemplates();
 
     try {
         // load warps
@@ -289,7 +291,7 @@ static void loadPaths(json& pathData, int32_t* nextId) {
         // slider circuit
         json pathDataSlider = pathData["slider"];
         // lerp between keyframes
-        std::queue<Vec3> route;
+        std::vector<Vec3> route;
         // initial point
         json::iterator _point = pathDataSlider.begin(); // iterator
         auto point = _point.value();
@@ -299,7 +301,7 @@ static void loadPaths(json& pathData, int32_t* nextId) {
         for (_point++; _point != pathDataSlider.end(); _point++) { // loop through all point Bs
             point = _point.value();
             for (int i = 0; i < stopTime + 1; i++) { // repeat point if it's a stop
-                route.push(from); // add point A to the queue
+                route.push_back(from); // add point A to the route
             }
             Vec3 to = { point["iX"] , point["iY"] , point["iZ"] }; // point B coords
             // we may need to change this later; right now, the speed is cut before and after stops (no accel)
@@ -313,15 +315,15 @@ static void loadPaths(json& pathData, int32_t* nextId) {
             from = to; // update point A
             stopTime = point["bStop"] ? SLIDER_STOP_TICKS : 0; // set stop ticks for next point A
         }
+        // every slider shares the circuit, each starting at a different point of it
+        RoutePoints circuit = std::make_shared<const std::vector<Vec3>>(std::move(route));
         // Uniform distance calculation
         int passedDistance = 0;
         // initial point
-        int pos = 0;
-        Vec3 lastPoint = route.front();
-        route.pop();
-        route.push(lastPoint);
-        for (pos = 1; pos < route.size(); pos++) {
-            Vec3 point = route.front();
+        size_t pos = 0;
+        Vec3 lastPoint = circuit->front();
+        for (pos = 1; pos < circuit->size(); pos++) {
+            Vec3 point = (*circuit)[pos];
             passedDistance += hypot(point.x - lastPoint.x, point.y - lastPoint.y);
             if (passedDistance >= SLIDER_GAP_SIZE) { // space them out uniformaly
                 passedDistance -= SLIDER_GAP_SIZE; // step down
@@ -329,11 +331,8 @@ static void loadPaths(json& pathData, int32_t* nextId) {
                 Bus* slider = new Bus(0, INSTANCE_OVERWORLD, 1, (*nextId)--);
                 NPCManager::NPCs[slider->id] = slider;
                 NPCManager::updateNPCPosition(slider->id, point.x, point.y, point.z, INSTANCE_OVERWORLD, 0);
-                Transport::NPCQueues[slider->id] = route;
+                Transport::NPCRoutes[slider->id] = NPCRoute(circuit, pos, {});
             }
-            // rotate
-            route.pop();
-            route.push(point);
             lastPoint = point;
         }
 
@@ -807,7 +806,7 @@ static void loadGruntworkPost(json& gruntwork, int32_t* nextId) {
 
             if (NPCManager::NPCData[(int)mob["iNPCType"]]["m_iTeam"] == 2) {
                 npc = new Mob(mob["iX"], mob["iY"], mob["iZ"], instanceID, mob["iNPCType"],
-                    NPCManager::NPCData[(int)mob["iNPCType"]], id);
+                    &MobAI::Templates[(int)mob["iNPCType"]], id);
 
                 // re-enable respawning
                 ((Mob*)npc)->summoned = false;
@@ -827,7 +826,7 @@ static void loadGruntworkPost(json& gruntwork, int32_t* nextId) {
 
             ensureValidNPCType((int)leader["iNPCType"], settings::GRUNTWORKJSON);
 
-            auto td = NPCManager::NPCData[(int)leader["iNPCType"]];
+            const MobTemplate *td = &MobAI::Templates[(int)leader["iNPCType"]];
             uint64_t instanceID = leader.find("iMapNum") == leader.end() ? INSTANCE_OVERWORLD : (int)leader["iMapNum"];
 
             Mob* tmp = new Mob(leader["iX"], leader["iY"], leader["iZ"], leader["iAngle"], instanceID, leader["iNPCType"], td, *nextId);
@@ -850,7 +849,7 @@ static void loadGruntworkPost(json& gruntwork, int32_t* nextId) {
 
                     ensureValidNPCType((int)follower["iNPCType"], settings::GRUNTWORKJSON);
 
-                    auto tdFol = NPCManager::NPCData[(int)follower["iNPCType"]];
+                    const MobTemplate *tdFol = &MobAI::Templates[(int)follower["iNPCType"]];
                     Mob* tmpFol = new Mob((int)leader["iX"] + (int)follower["iOffsetX"], (int)leader["iY"] + (int)follower["iOffsetY"], leader["iZ"], leader["iAngle"], instanceID, follower["iNPCType"], tdFol, *nextId);
 
                     // re-enable respawning
@@ -953,7 +952,7 @@ static void loadMobs(json& npcData, int32_t* nextId) {
 
             ensureValidNPCType(type, settings::MOBJSON);
 
-            auto td = NPCManager::NPCData[type];
+            const MobTemplate *td = &MobAI::Templates[type];
             uint64_t instanceID = npc.find("iMapNum") == npc.end() ? INSTANCE_OVERWORLD : (int)npc["iMapNum"];
 
 #ifdef ACADEMY
@@ -984,7 +983,7 @@ static void loadMobs(json& npcData, int32_t* nextId) {
             leadID += MOB_GROUP_ID_OFFSET;
             ensureValidNPCType(leader["iNPCType"], settings::MOBJSON);
 
-            auto td = NPCManager::NPCData[(int)leader["iNPCType"]];
+            const MobTemplate *td = &MobAI::Templates[(int)leader["iNPCType"]];
             uint64_t instanceID = leader.find("iMapNum") == leader.end() ? INSTANCE_OVERWORLD : (int)leader["iMapNum"];
             auto followers = leader["aFollowers"];
 
@@ -1016,7 +1015,7 @@ static void loadMobs(json& npcData, int32_t* nextId) {
 
                     ensureValidNPCType(follower["iNPCType"], settings::MOBJSON);
 
-                    auto tdFol = NPCManager::NPCData[(int)follower["iNPCType"]];
+                    const MobTemplate *tdFol = &MobAI::Templates[(int)follower["iNPCType"]];
                     Mob* tmpFol = new Mob((int)leader["iX"] + (int)follower["iOffsetX"], (int)leader["iY"] + (int)follower["iOffsetY"], leader["iZ"], leader["iAngle"], instanceID, follower["iNPCType"], tdFol, *nextId);
 
                     NPCManager::NPCs[*nextId] = tmpFol;
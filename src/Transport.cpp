@@ -19,7 +19,7 @@ std::map<int32_t, TransportLocation> Transport::Locations;
 std::vector<NPCPath> Transport::NPCPaths;
 std::map<int32_t, std::queue<Vec3>> Transport::SkywayPaths;
 std::unordered_map<CNSocket*, std::queue<Vec3>> Transport::SkywayQueues;
-std::unordered_map<int32_t, std::queue<Vec3>> Transport::NPCQueues;
+std::unordered_map<int32_t, NPCRoute> Transport::NPCRoutes;
 
 static void transportRegisterLocationHandler(CNSocket* sock, CNPacketData* data) {
     auto transport = (sP_CL2FE_REQ_REGIST_TRANSPORTATION_LOCATION*)data->buf;
@@ -243,19 +243,19 @@ static void stepSkywaySystem() {
 
 static void stepNPCPathing() {
 
-    // all NPC pathing queues
-    std::unordered_map<int32_t, std::queue<Vec3>>::iterator it = NPCQueues.begin();
-    while (it != NPCQueues.end()) {
+    // all NPC routes
+    std::unordered_map<int32_t, NPCRoute>::iterator it = NPCRoutes.begin();
+    while (it != NPCRoutes.end()) {
 
-        std::queue<Vec3>* queue = &it->second;
+        NPCRoute* route = &it->second;
 
         BaseNPC* npc = nullptr;
         if (NPCManager::NPCs.find(it->first) != NPCManager::NPCs.end())
             npc = NPCManager::NPCs[it->first];
 
-        if (npc == nullptr || queue->empty()) {
+        if (npc == nullptr || route->empty()) {
             // pluck out dead path + update iterator
-            it = NPCQueues.erase(it);
+            it = NPCRoutes.erase(it);
             continue;
         }
 
@@ -271,8 +271,8 @@ static void stepNPCPathing() {
             continue;
         }
 
-        Vec3 point = queue->front(); // get point
-        queue->pop(); // remove point from front of queue
+        Vec3 point = route->front(); // get point
+        route->advance(npc->loopingPath); // if this path should be repeated, start over at the end
 
         // calculate displacement
         int dXY = hypot(point.x - npc->x, point.y - npc->y); // XY plane distance
@@ -312,12 +312,6 @@ static void stepNPCPathing() {
             break;
         }
 
-        /*
-         * If this path should be repeated, move processed point to the back to maintain cycle.
-         */
-        if (npc->loopingPath)
-            queue->push(point);
-
         it++; // go to next entry in map
     }
 }
@@ -328,9 +322,9 @@ static void tickTransportationSystem(CNServer* serv, time_t currTime) {
 }
 
 /*
- * Linearly interpolate between two points and insert the results into a queue.
+ * Linearly interpolate between two points and append the results to a route.
  */
-void Transport::lerp(std::queue<Vec3>* queue, Vec3 start, Vec3 end, int gapSize, float curve) {
+void Transport::lerp(std::vector<Vec3>* points, Vec3 start, Vec3 end, int gapSize, float curve) {
     int dXY = hypot(end.x - start.x, end.y - start.y); // XY plane distance
     int distanceBetween = hypot(dXY, end.z - start.z); // total distance
     int lerps = distanceBetween / gapSize; // number of intermediate points to add
@@ -342,11 +336,17 @@ void Transport::lerp(std::queue<Vec3>* queue, Vec3 start, Vec3 end, int gapSize,
         lerp.x = (start.x * (1.0f - frac)) + (end.x * frac);
         lerp.y = (start.y * (1.0f - frac)) + (end.y * frac);
         lerp.z = (start.z * (1.0f - frac)) + (end.z * frac);
-        queue->push(lerp); // add lerp'd point
+        points->push_back(lerp); // add lerp'd point
     }
 }
+void Transport::lerp(std::vector<Vec3>* points, Vec3 start, Vec3 end, int gapSize) {
+    lerp(points, start, end, gapSize, 1);
+}
 void Transport::lerp(std::queue<Vec3>* queue, Vec3 start, Vec3 end, int gapSize) {
-    lerp(queue, start, end, gapSize, 1);
+    std::vector<Vec3> points;
+    lerp(&points, start, end, gapSize, 1);
+    for (Vec3& point : points)
+        queue->push(point);
 }
 
 /*
@@ -386,38 +386,41 @@ NPCPath* Transport::findApplicablePath(int32_t id, int32_t type, int taskID) {
     return match;
 }
 
+/*
+ * Interpolate a path's keyframes into a full route.
+ * Relative paths are interpolated around the origin, to be offset by each NPC.
+ */
+static RoutePoints buildRoute(NPCPath* path) {
+    std::vector<Vec3> points;
+
+    auto _point = path->points.begin();
+    Vec3 from = *_point; // point A coords
+    for (_point++; _point != path->points.end(); _point++) { // loop through all point Bs
+        Vec3 to = *_point; // point B coords
+        points.push_back(from); // add point A to the route
+        Transport::lerp(&points, from, to, path->speed); // lerp from A to B
+        from = to; // update point A
+    }
+
+    return std::make_shared<const std::vector<Vec3>>(std::move(points));
+}
+
 void Transport::constructPathNPC(int32_t id, NPCPath* path) {
     BaseNPC* npc = NPCManager::NPCs[id];
     if (npc->kind == EntityKind::MOB)
         ((Mob*)(npc))->staticPath = true;
     npc->loopingPath = path->isLoop;
 
-    // Interpolate
-    std::vector<Vec3> pathPoints = path->points;
-    std::queue<Vec3> points;
+    // shared between every NPC on this path
+    if (path->route == nullptr)
+        path->route = buildRoute(path);
 
-    auto _point = pathPoints.begin();
-    Vec3 from = *_point; // point A coords
-    for (_point++; _point != pathPoints.end(); _point++) { // loop through all point Bs
-        Vec3 to = *_point; // point B coords
-        // add point A to the queue
-        if (path->isRelative) {
-            // relative; the NPCs current position is assumed to be its spawn point
-            Vec3 fromReal = { from.x + npc->x, from.y + npc->y, from.z + npc->z };
-            Vec3 toReal = { to.x + npc->x, to.y + npc->y, to.z + npc->z };
-            points.push(fromReal);
-            Transport::lerp(&points, fromReal, toReal, path->speed); // lerp from A to B
-        }
-        else {
-            // absolute
-            points.push(from);
-            Transport::lerp(&points, from, to, path->speed); // lerp from A to B
-        }
-
-        from = to; // update point A
-    }
+    // relative; the NPCs current position is assumed to be its spawn point
+    Vec3 offset = {};
+    if (path->isRelative)
+        offset = { npc->x, npc->y, npc->z };
 
-    Transport::NPCQueues[id] = points;
+    Transport::NPCRoutes[id] = NPCRoute(path->route, 0, offset);
 }
 
 void Transport::init() {
@@ -6,6 +6,7 @@
 #include <map>
 #include <vector>
 #include <queue>
+#include <memory>
 
 const int SLIDER_SPEED = 1200;
 const int SLIDER_STOP_TICKS = 16;
@@ -29,6 +30,9 @@ struct TransportLocation {
     int npcID, x, y, z;
 };
 
+// fully interpolated points of an NPC route; immutable so it can be shared
+typedef std::shared_ptr<const std::vector<Vec3>> RoutePoints;
+
 struct NPCPath {
     std::vector<Vec3> points;
     std::vector<int32_t> targetIDs;
@@ -37,6 +41,37 @@ struct NPCPath {
     int escortTaskID;
     bool isRelative;
     bool isLoop;
+    RoutePoints route; // interpolated on first use, relative to the origin if isRelative
+};
+
+/*
+ * An NPC's progress along a route. Routes built from an NPCPath are shared by
+ * every NPC walking it, with relative ones shifted by each NPC's offset; other
+ * routes are one-offs, owned by the only NPC that walks them.
+ */
+struct NPCRoute {
+    RoutePoints points;
+    size_t pos = 0;
+    Vec3 offset = {};
+
+    NPCRoute() {}
+    NPCRoute(std::vector<Vec3>&& pts)
+        : points(std::make_shared<const std::vector<Vec3>>(std::move(pts))) {}
+    NPCRoute(RoutePoints pts, size_t start, Vec3 off)
+        : points(pts), pos(start), offset(off) {}
+
+    bool empty() const { return points == nullptr || pos >= points->size(); }
+
+    Vec3 front() const {
+        const Vec3& point = (*points)[pos];
+        return { point.x + offset.x, point.y + offset.y, point.z + offset.z };
+    }
+
+    // looping routes wrap around to the start instead of running out
+    void advance(bool loop) {
+        if (++pos >= points->size() && loop)
+            pos = 0;
+    }
 };
 
 namespace Transport {
@@ -45,13 +80,14 @@ namespace Transport {
     extern std::vector<NPCPath> NPCPaths; // predefined NPC paths
     extern std::map<int32_t, std::queue<Vec3>> SkywayPaths; // predefined skyway paths with points
     extern std::unordered_map<CNSocket*, std::queue<Vec3>> SkywayQueues; // player sockets with queued broomstick points
-    extern std::unordered_map<int32_t, std::queue<Vec3>> NPCQueues; // NPC ids with queued pathing points
+    extern std::unordered_map<int32_t, NPCRoute> NPCRoutes; // NPC ids with the route they're walking
 
     void init();
 
     void testMssRoute(CNSocket *sock, std::vector<Vec3>* route);
 
-    void lerp(std::queue<Vec3>*, Vec3, Vec3, int, float);
+    void lerp(std::vector<Vec3>*, Vec3, Vec3, int, float);
+    void lerp(std::vector<Vec3>*, Vec3, Vec3, int);
     void lerp(std::queue<Vec3>*, Vec3, Vec3, int);
 
     NPCPath* findApplicablePath(int32_t, int32_t, int = -1);
@@ -1,8 +1,13 @@
 #include "core/CNProtocol.hpp"
+#include "core/EventLoop.hpp"
 #include "CNStructs.hpp"
 
 #include <assert.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 // ========================================================[[ CNSocketEncryption ]]========================================================
 
 // literally C/P from the client and converted to C++ (does some byte swapping /shrug)
@@ -29,9 +34,39 @@ int CNSocketEncryption::Encrypt_byte_change_A(int ERSize, uint8_t* data, int siz
     return num + num2;
 }
 
+/*
+ * Since the key is exactly 8 bytes long and always lines up with the start
+ * of the buffer, we can xor whole words (or 16-byte vectors) at a time and
+ * only fall back to single bytes for the tail.
+ *
+ * memcpy() is used for the loads and stores, as the buffer isn't
+ * necessarily aligned. It compiles down to plain moves.
+ */
 int CNSocketEncryption::xorData(uint8_t* buffer, uint8_t* key, int size) {
-    // xor every 8 bytes with 8 byte key
-    for (int i = 0; i < size; i++) {
+    static_assert(keyLength == sizeof(uint64_t), "xorData() assumes an 8 byte key");
+
+    uint64_t k;
+    memcpy(&k, key, sizeof(k));
+
+    int i = 0;
+
+#ifdef __SSE2__
+    __m128i kv = _mm_set1_epi64x((long long)k);
+    for (; i + 16 <= size; i += 16) {
+        __m128i v = _mm_loadu_si128((__m128i*)(buffer + i));
+        _mm_storeu_si128((__m128i*)(buffer + i), _mm_xor_si128(v, kv));
+    }
+#endif
+
+    for (; i + 8 <= size; i += 8) {
+        uint64_t w;
+        memcpy(&w, buffer + i, sizeof(w));
+        w ^= k;
+        memcpy(buffer + i, &w, sizeof(w));
+    }
+
+    // xor the remaining bytes with the start of the key
+    for (; i < size; i++) {
         buffer[i] ^= key[i % keyLength];
     }
 
@@ -65,30 +100,65 @@ CNPacketData::CNPacketData(void *b, uint32_t t, int l, int trnum, void *trs):
 
 // ========================================================[[ CNSocket ]]========================================================
 
-CNSocket::CNSocket(SOCKET s, struct sockaddr_in &addr, PacketHandler ph): sock(s), sockaddr(addr), pHandler(ph) {
+CNSocket::CNSocket(SOCKET s, struct sockaddr_in &addr, PacketHandler ph, CNServer *serv): server(serv), sock(s), sockaddr(addr), pHandler(ph) {
     memcpy(&EKey, CNSocketEncryption::defaultKey, sizeof(EKey));
 }
 
-bool CNSocket::sendData(uint8_t* data, int size) {
-    int sentBytes = 0;
-    int maxTries = 10;
+/*
+ * Writes as much of the send buffer as the kernel will take right now.
+ * Returns false only on a real socket error; running out of kernel buffer
+ * space just leaves the rest queued and sets writeBlocked.
+ */
+bool CNSocket::sendData() {
+    writeBlocked = false;
 
-    while (sentBytes < size) {
-        int sent = send(sock, (buffer_t*)(data + sentBytes), size - sentBytes, 0);
+    while (sendBufferIndex < sendBuffer.size()) {
+        int sent = send(sock, (buffer_t*)(sendBuffer.data() + sendBufferIndex), sendBuffer.size() - sendBufferIndex, 0);
         if (SOCKETERROR(sent)) {
-            if (OF_ERRNO == OF_EWOULD && maxTries > 0) {
-                maxTries--;
-                continue; // try again
+            if (OF_ERRNO == OF_EWOULD) {
+                writeBlocked = true;
+                break;
             }
             printSocketError("send");
             return false; // error occured while sending bytes
         }
-        sentBytes += sent;
+        sendBufferIndex += sent;
+    }
+
+    if (sendBufferIndex == sendBuffer.size()) {
+        // everything went out; keep the capacity around for the next tick
+        sendBuffer.clear();
+        sendBufferIndex = 0;
+    } else if (sendBufferIndex > sendBuffer.size() / 2) {
+        // drop the part that was already sent so the buffer doesn't creep
+        sendBuffer.erase(sendBuffer.begin(), sendBuffer.begin() + sendBufferIndex);
+        sendBufferIndex = 0;
     }
 
     return true; // it worked!
 }
 
+void CNSocket::flush() {
+    flushQueued = false;
+
+    if (!alive)
+        return;
+
+    bool wasBlocked = writeBlocked;
+    if (!sendData()) {
+        kill();
+        return;
+    }
+
+    // wait for POLLOUT if the kernel couldn't take everything
+    if (writeBlocked != wasBlocked)
+        server->setWritable(sock, writeBlocked);
+}
+
+bool CNSocket::isWriteBlocked() {
+    return writeBlocked;
+}
+
 void CNSocket::setEKey(uint64_t k) {
     EKey = k;
 }
@@ -109,26 +179,46 @@ bool CNSocket::isAlive() {
     return alive;
 }
 
+/*
+ * The descriptor itself is only closed once the server has stopped watching
+ * it and deletes the CNSocket, so that its number can't be reused by a new
+ * connection while the event loop still knows about the old one.
+ */
 void CNSocket::kill() {
     if (!alive)
         return;
 
+    /*
+     * Give whatever we queued right before killing the connection
+     * (ex. EXIT_DUPLICATE) a chance to go out. This is best-effort; if the
+     * peer already hung up, failing here is expected and not worth a print.
+     */
+    if (sendBufferIndex < sendBuffer.size())
+        send(sock, (buffer_t*)(sendBuffer.data() + sendBufferIndex), sendBuffer.size() - sendBufferIndex, 0);
+
     alive = false;
 
 #ifdef _WIN32
     shutdown(sock, SD_BOTH);
-    closesocket(sock);
 #else
     shutdown(sock, SHUT_RDWR);
+#endif
+}
+
+CNSocket::~CNSocket() {
+#ifdef _WIN32
+    closesocket(sock);
+#else
     close(sock);
 #endif
 }
 
 void CNSocket::validatingSendPacket(void *pkt, uint32_t packetType) {
     assert(isOutboundPacketID(packetType));
-    assert(Packets::packets.find(packetType) != Packets::packets.end());
+    const PacketDesc *descp = Packets::getDesc(packetType);
+    assert(descp != nullptr);
 
-    PacketDesc& desc = Packets::packets[packetType];
+    const PacketDesc& desc = *descp;
     size_t resplen = desc.size;
 
     /*
@@ -150,24 +240,13 @@ void CNSocket::sendPacket(void* buf, uint32_t type, size_t size) {
     if (!alive)
         return;
 
-    uint8_t fullpkt[CN_PACKET_BUFFER_SIZE]; // length, type, body
-    uint8_t* body = fullpkt + 4; // packet without length (type, body)
-    size_t bodysize = size + 4;
-
-    // set packet length
-    memcpy(fullpkt, (void*)&bodysize, 4);
-
-    // copy packet type to the front of the buffer & then the actual buffer
-    memcpy(body, (void*)&type, 4);
-    memcpy(body+4, buf, size);
-
-    // encrypt the packet
+    uint64_t *key;
     switch (activeKey) {
     case SOCKETKEY_E:
-        CNSocketEncryption::encryptData((uint8_t*)body, (uint8_t*)(&EKey), bodysize);
+        key = &EKey;
         break;
     case SOCKETKEY_FE:
-        CNSocketEncryption::encryptData((uint8_t*)body, (uint8_t*)(&FEKey), bodysize);
+        key = &FEKey;
         break;
     default:
         DEBUGLOG(
@@ -176,9 +255,36 @@ void CNSocket::sendPacket(void* buf, uint32_t type, size_t size) {
         return;
     }
 
-    // send packet data!
-    if (alive && !sendData(fullpkt, bodysize+4))
+    size_t bodysize = size + 4;
+
+    // a client that stopped reading altogether shouldn't grow this forever
+    if (sendBuffer.size() - sendBufferIndex + bodysize + 4 > CN_SEND_BUFFER_LIMIT) {
+        std::cerr << "[WARN] OpenFusion: send buffer overflow, dropping connection" << std::endl;
         kill();
+        return;
+    }
+
+    // build the packet directly at the end of the send buffer
+    size_t start = sendBuffer.size();
+    sendBuffer.resize(start + bodysize + 4);
+    uint8_t* fullpkt = sendBuffer.data() + start; // length, type, body
+    uint8_t* body = fullpkt + 4; // packet without length (type, body)
+
+    // set packet length
+    memcpy(fullpkt, (void*)&bodysize, 4);
+
+    // copy packet type to the front of the buffer & then the actual buffer
+    memcpy(body, (void*)&type, 4);
+    memcpy(body+4, buf, size);
+
+    // encrypt the packet
+    CNSocketEncryption::encryptData(body, (uint8_t*)key, bodysize);
+
+    // it'll actually be sent at the end of this event loop iteration
+    if (!flushQueued && !writeBlocked) {
+        flushQueued = true;
+        server->queueFlush(this);
+    }
 }
 
 void CNSocket::setActiveKey(ACTIVEKEY key) {
@@ -190,7 +296,8 @@ inline void CNSocket::parsePacket(uint8_t *buf, size_t size) {
     uint8_t *body = buf + 4;
     size_t pktSize = size - 4;
 
-    if (Packets::packets.find(type) == Packets::packets.end()) {
+    const PacketDesc *descp = Packets::getDesc(type);
+    if (descp == nullptr) {
         std::cerr << "OpenFusion: UNKNOWN PACKET: " << (int)type << std::endl;
         return;
     }
@@ -200,7 +307,7 @@ inline void CNSocket::parsePacket(uint8_t *buf, size_t size) {
         return;
     }
 
-    PacketDesc& desc = Packets::packets[type];
+    const PacketDesc& desc = *descp;
 
     /*
      * Some packet structs with no meaningful contents have length 1, but
@@ -210,7 +317,7 @@ inline void CNSocket::parsePacket(uint8_t *buf, size_t size) {
      * packet's contents.
      *
      * Assigning a zero byte to the body like this is safe, since there's a
-     * huge empty buffer behind that pointer.
+     * huge empty buffer behind that pointer (packetBuffer).
      */
     if (!desc.variadic && desc.size == 1 && pktSize == 0) {
         pktSize = 1;
@@ -221,12 +328,12 @@ inline void CNSocket::parsePacket(uint8_t *buf, size_t size) {
     if (desc.variadic) {
         ntrailers = *(int32_t*)(body + desc.cntMembOfs);
         if (!validInVarPacket(desc.size, ntrailers, desc.trailerSize, pktSize)) {
-            std::cerr << "[WARN] Received invalid variadic packet: " << desc.name << " (" << type << ")" << std::endl;
+            std::cerr << "[WARN] Received invalid variadic packet: " << Packets::p2str(type) << " (" << type << ")" << std::endl;
             return;
         }
 
     } else if (!desc.variadic && pktSize != desc.size) {
-        std::cerr << "[WARN] Received " << desc.name << " (" << type << ") of wrong size ("
+        std::cerr << "[WARN] Received " << Packets::p2str(type) << " (" << type << ") of wrong size ("
             << (int)pktSize << " vs " << desc.size << ")" << std::endl;
         return;
     }
@@ -242,25 +349,15 @@ inline void CNSocket::parsePacket(uint8_t *buf, size_t size) {
 void CNSocket::step() {
     // read step
 
-    // XXX NOTE: we must not recv() twice without a poll() inbetween
-    if (readSize <= 0) {
-        // we aren't reading a packet yet, try to start looking for one
-        int recved = recv(sock, (buffer_t*)readBuffer, sizeof(int32_t), 0);
-        if (recved >= 0 && recved < sizeof(int32_t)) {
-            // too little data for readSize or the socket was closed normally (when 0 bytes were read)
+    // grab as much as we have room for in one go
+    if (readBufferIndex < CN_RECV_BUFFER_SIZE) {
+        int recved = recv(sock, (buffer_t*)(readBuffer + readBufferIndex), CN_RECV_BUFFER_SIZE - readBufferIndex, 0);
+        if (recved == 0) {
+            // the socket was closed normally
             kill();
             return;
         } else if (!SOCKETERROR(recved)) {
-            // we got our packet size!!!!
-            readSize = *((int32_t*)readBuffer);
-            // sanity check
-            if (readSize > CN_PACKET_BUFFER_SIZE) {
-                kill();
-                return;
-            }
-
-            // we'll just leave bufferIndex at 0 since we already have the packet size, it's safe to overwrite those bytes
-            activelyReading = true;
+            readBufferIndex += recved;
         } else if (OF_ERRNO != OF_EWOULD) {
             // serious socket issue, disconnect connection
             printSocketError("recv");
@@ -269,36 +366,78 @@ void CNSocket::step() {
         }
     }
 
-    if (readSize > 0 && readBufferIndex < readSize) {
-        // read until the end of the packet (or at least try to)
-        int recved = recv(sock, (buffer_t*)(readBuffer + readBufferIndex), readSize - readBufferIndex, 0);
-        if (recved == 0) {
-            // the socket was closed normally
-            kill();
-            return;
-        } else if (!SOCKETERROR(recved))
-            readBufferIndex += recved;
-        else if (OF_ERRNO != OF_EWOULD) {
-            // serious socket issue, disconnect connection
-            printSocketError("recv");
+    // already had its turn this iteration; see CNServer::stepReadQueue()
+    if (readQueued)
+        return;
+
+    handlePackets();
+}
+
+bool CNSocket::hasFullPacket() {
+    if (readBufferIndex < (int)sizeof(int32_t))
+        return false;
+
+    int32_t readSize;
+    memcpy(&readSize, readBuffer, sizeof(int32_t));
+    return readBufferIndex - (int)sizeof(int32_t) >= readSize;
+}
+
+/*
+ * Dispatches every complete packet in readBuffer, up to the per-tick
+ * budget. Sockets with packets left over get queued on the server so the
+ * rest are handled next iteration, even if no more data arrives.
+ */
+void CNSocket::handlePackets() {
+    int offset = 0;
+    int budget = std::max(settings::PACKETSPERTICK, 1);
+
+    while (alive && budget > 0 && readBufferIndex - offset >= (int)sizeof(int32_t)) {
+        int32_t readSize;
+        memcpy(&readSize, readBuffer + offset, sizeof(int32_t));
+
+        // sanity check
+        if (readSize < (int32_t)sizeof(int32_t) || readSize > CN_PACKET_BUFFER_SIZE) {
             kill();
             return;
         }
+
+        // wait for the rest of it
+        if (readBufferIndex - offset - (int)sizeof(int32_t) < readSize)
+            break;
+
+        /*
+         * Decrypt each packet right before handling it, since handling one
+         * can change the key used for the next.
+         */
+        memcpy(packetBuffer, readBuffer + offset + sizeof(int32_t), readSize);
+        CNSocketEncryption::decryptData(packetBuffer, (uint8_t*)(&EKey), readSize);
+
+        offset += sizeof(int32_t) + readSize;
+        budget--;
+
+        parsePacket(packetBuffer, readSize);
     }
 
-    if (activelyReading && readBufferIndex >= readSize) {
-        // decrypt readBuffer and copy to CNPacketData
-        CNSocketEncryption::decryptData((uint8_t*)&readBuffer, (uint8_t*)(&EKey), readSize);
+    if (!alive)
+        return;
 
-        parsePacket(readBuffer, readSize);
+    // move any partial packet to the front
+    if (offset > 0) {
+        memmove(readBuffer, readBuffer + offset, readBufferIndex - offset);
+        readBufferIndex -= offset;
+    }
 
-        // reset vars :)
-        readSize = 0;
-        readBufferIndex = 0;
-        activelyReading = false;
+    if (hasFullPacket() && !readQueued) {
+        readQueued = true;
+        server->queueRead(this);
     }
 }
 
+void CNSocket::handleQueuedPackets() {
+    readQueued = false;
+    handlePackets();
+}
+
 void printSocketError(const char *call) {
 #ifdef _WIN32
     std::cerr << call << ": ";
@@ -406,52 +545,63 @@ void CNServer::init() {
         exit(EXIT_FAILURE);
     }
 
-    // poll() configuration
-    fds.reserve(STARTFDSCOUNT);
-    fds.push_back({sock, POLLIN});
+    eventLoop = EventLoop::create();
+    eventLoop->add(sock);
 }
 
 CNServer::CNServer() {};
 CNServer::CNServer(uint16_t p): port(p) {}
 
-void CNServer::addPollFD(SOCKET s) {
-    fds.push_back({s, POLLIN});
+CNServer::~CNServer() {
+    delete eventLoop;
 }
 
-void CNServer::removePollFD(int fd) {
-    auto it = fds.begin();
-    while (it != fds.end() && it->fd != fd)
-        it++;
-    assert(it != fds.end());
+void CNServer::addPollFD(SOCKET s) {
+    eventLoop->add(s);
+}
 
-    fds.erase(it);
+void CNServer::removePollFD(SOCKET s) {
+    eventLoop->remove(s);
 }
 
 void CNServer::start() {
-    std::cout << "Starting server at *:" << port << std::endl;
+    std::cout << "Starting server at *:" << port << " (" << eventLoop->name() << ")" << std::endl;
     while (active) {
+        readyEvents.clear();
+
         // the timeout is to ensure shard timers are ticking
-        int n = poll(fds.data(), fds.size(), 50);
-        if (SOCKETERROR(n)) {
+        int n = eventLoop->wait(readyEvents, readQueue.empty() ? waitTimeout() : 0);
+        if (n < 0) {
 #ifndef _WIN32
             if (errno == EINTR)
                 continue;
 #endif
-            std::cout << "[FATAL] poll() returned error" << std::endl;
-            printSocketError("poll");
+            std::cout << "[FATAL] " << eventLoop->name() << "() returned error" << std::endl;
+            printSocketError(eventLoop->name());
             terminate(0);
         }
 
-        for (int i = 0; i < fds.size() && n > 0; i++) {
-            if (fds[i].revents == 0)
-                continue; // nothing in this one; don't decrement n
+        /*
+         * Handle packets that were left over from previous iterations first.
+         * Sockets that get stepped here won't dispatch any more packets
+         * if they also became readable, so each socket gets at most one
+         * packet budget's worth per iteration.
+         */
+        {
+            std::lock_guard<std::mutex> lock(activeCrit); // protect operations on connections
+
+            // halt packet handling if server is shutting down
+            if (!active)
+                return;
 
-            n--;
+            stepReadQueue();
+        }
 
+        for (ReadyEvent& ev : readyEvents) {
             // is it the listener?
-            if (fds[i].fd == sock) {
+            if (ev.fd == sock) {
                 // any sort of error on the listener
-                if (fds[i].revents & ~POLLIN) {
+                if (ev.revents & ~POLLIN) {
                     std::cout << "[FATAL] Error on listener socket" << std::endl;
                     terminate(0);
                 }
@@ -470,11 +620,11 @@ void CNServer::start() {
                 addPollFD(newConnectionSocket);
 
                 // add connection to list!
-                CNSocket* tmp = new CNSocket(newConnectionSocket, address, pHandler);
+                CNSocket* tmp = new CNSocket(newConnectionSocket, address, pHandler, this);
                 connections[newConnectionSocket] = tmp;
                 newConnection(tmp);
 
-            } else if (checkExtraSockets(i)) {
+            } else if (checkExtraSockets(ev.fd, ev.revents)) {
                 // no-op. handled in checkExtraSockets().
 
             } else {
@@ -485,25 +635,41 @@ void CNServer::start() {
                     return;
 
                 // player sockets
-                if (connections.find(fds[i].fd) == connections.end()) {
-                    std::cout << "[FATAL] Event on non-existent socket: " << fds[i].fd << std::endl;
+                auto it = connections.find(ev.fd);
+                if (it == connections.end()) {
+                    std::cout << "[FATAL] Event on non-existent socket: " << ev.fd << std::endl;
                     assert(0);
                     /* not reached */
                 }
 
-                CNSocket* cSock = connections[fds[i].fd];
+                CNSocket* cSock = it->second;
 
                 // kill the socket on hangup/error
-                if (fds[i].revents & ~POLLIN)
+                if (ev.revents & ~(POLLIN | POLLOUT))
                     cSock->kill();
 
-                if (cSock->isAlive())
+                // the kernel has room for the rest of our queued output
+                if (cSock->isAlive() && (ev.revents & POLLOUT))
+                    cSock->flush();
+
+                if (cSock->isAlive() && (ev.revents & POLLIN))
                     cSock->step();
             }
         }
 
         onStep();
 
+        /*
+         * CNServer::kill() may be deleting every socket from another thread,
+         * so the flush and clean-up passes need the lock as well.
+         */
+        std::lock_guard<std::mutex> lock(activeCrit);
+        if (!active)
+            return;
+
+        // send everything that was queued during this iteration
+        flushConnections();
+
         // clean up dead connection sockets
         auto it = connections.begin();
         while (it != connections.end()) {
@@ -513,6 +679,9 @@ void CNServer::start() {
                 killConnection(cSock);
                 it = connections.erase(it);
 
+                // it might've been killed after being queued for reading
+                readQueue.erase(std::remove(readQueue.begin(), readQueue.end(), cSock), readQueue.end());
+
                 removePollFD(cSock->sock);
 
                 delete cSock;
@@ -523,10 +692,45 @@ void CNServer::start() {
     }
 }
 
+void CNServer::queueFlush(CNSocket *cns) {
+    flushQueue.push_back(cns);
+}
+
+void CNServer::flushConnections() {
+    // dead sockets are only deleted after this, so every entry is still valid
+    for (CNSocket *cSock : flushQueue)
+        cSock->flush();
+
+    flushQueue.clear();
+}
+
+void CNServer::queueRead(CNSocket *cns) {
+    readQueue.push_back(cns);
+}
+
+void CNServer::stepReadQueue() {
+    // sockets that still have packets left get re-queued as we go
+    readQueueTmp.swap(readQueue);
+
+    for (CNSocket *cSock : readQueueTmp) {
+        if (cSock->isAlive())
+            cSock->handleQueuedPackets();
+    }
+
+    readQueueTmp.clear();
+}
+
+void CNServer::setWritable(SOCKET s, bool writable) {
+    eventLoop->setWritable(s, writable);
+}
+
 void CNServer::kill() {
     std::lock_guard<std::mutex> lock(activeCrit); // the lock will be removed when the function ends
     active = false;
 
+    flushQueue.clear();
+    readQueue.clear();
+
     // kill all connections
     for (auto& pair : connections) {
         CNSocket *cSock = pair.second;
@@ -561,7 +765,8 @@ void CNServer::printPacket(CNPacketData *data) {
     std::cout << "OpenFusion: received " << Packets::p2str(data->type) << " (" << data->type << ")" << std::endl;
 }
 
-bool CNServer::checkExtraSockets(int i) { return false; } // stubbed
+bool CNServer::checkExtraSockets(SOCKET fd, int revents) { return false; } // stubbed
 void CNServer::newConnection(CNSocket* cns) {} // stubbed
 void CNServer::killConnection(CNSocket* cns) {} // stubbed
 void CNServer::onStep() {} // stubbed
+int CNServer::waitTimeout() { return 50; }
@@ -71,6 +71,19 @@
  *         [trailing data] - optional variable-length data that only some packets make use of
  */
 
+/*
+ * Outbound packets are queued per socket and flushed once per event loop
+ * iteration. A client that lets this much data pile up without reading it
+ * is considered dead.
+ */
+#define CN_SEND_BUFFER_LIMIT (1 << 20)
+
+/*
+ * Inbound data is read in bulk, so several pipelined packets can be
+ * handled per wakeup. Must be able to hold at least one full packet.
+ */
+#define CN_RECV_BUFFER_SIZE (CN_PACKET_BUFFER_SIZE * 4)
+
 // error checking calloc wrapper
 inline void* xmalloc(size_t sz) {
     void* res = calloc(1, sz);
@@ -158,24 +171,36 @@ enum ACTIVEKEY {
 };
 
 class CNSocket;
+class CNServer;
 typedef void (*PacketHandler)(CNSocket* sock, CNPacketData* data);
 
 class CNSocket {
 private:
     uint64_t EKey;
     uint64_t FEKey;
-    int32_t readSize = 0;
-    uint8_t readBuffer[CN_PACKET_BUFFER_SIZE];
+    // raw, still encrypted data received from the client
+    uint8_t readBuffer[CN_RECV_BUFFER_SIZE];
     int readBufferIndex = 0;
-    bool activelyReading = false;
+    // a single decrypted packet, as handed to pHandler
+    uint8_t packetBuffer[CN_PACKET_BUFFER_SIZE];
+    bool readQueued = false;
     bool alive = true;
 
+    // encrypted packets waiting to be written out; see flush()
+    std::vector<uint8_t> sendBuffer;
+    size_t sendBufferIndex = 0;
+    bool flushQueued = false;
+    bool writeBlocked = false;
+    CNServer *server;
+
     ACTIVEKEY activeKey;
 
-    bool sendData(uint8_t* data, int size);
+    bool sendData();
     int recvData(buffer_t* data, int size);
 
     inline void parsePacket(uint8_t *buf, size_t size);
+    bool hasFullPacket();
+    void handlePackets();
     void validatingSendPacket(void *buf, uint32_t packetType);
 
 public:
@@ -183,7 +208,8 @@ public:
     sockaddr_in sockaddr;
     PacketHandler pHandler;
 
-    CNSocket(SOCKET s, struct sockaddr_in &addr, PacketHandler ph);
+    CNSocket(SOCKET s, struct sockaddr_in &addr, PacketHandler ph, CNServer *serv);
+    ~CNSocket();
 
     void setEKey(uint64_t k);
     void setFEKey(uint64_t k);
@@ -194,7 +220,10 @@ public:
     void kill();
     void sendPacket(void* buf, uint32_t packetType, size_t size);
     void step();
+    void handleQueuedPackets();
+    void flush();
     bool isAlive();
+    bool isWriteBlocked();
 
     // generic, validating wrapper for sendPacket()
     template<class T>
@@ -207,28 +236,44 @@ public:
     }
 };
 
-class CNServer;
+class EventLoop; // see EventLoop.hpp
 typedef void (*TimerHandler)(CNServer* serv, time_t time);
 
 // timer struct
 struct TimerEvent {
     TimerHandler handlr;
+    const char *name;
     time_t delta; // time to be added to the current time on reset
     time_t scheduledEvent; // time to call handlr()
 
-    TimerEvent(TimerHandler h, time_t d): handlr(h), delta(d) {
+    // how late the handler got called, and how long it took to run
+    uint64_t runs = 0;
+    time_t totalLateness = 0;
+    time_t maxLateness = 0;
+    time_t maxRuntime = 0;
+
+    TimerEvent(TimerHandler h, time_t d, const char *n): handlr(h), name(n), delta(d) {
         scheduledEvent = 0;
     }
 };
 
+// a socket reported by EventLoop::wait(), with poll()-style revents
+struct ReadyEvent {
+    SOCKET fd;
+    int revents;
+};
+
 // in charge of accepting new connections and making sure each connection is kept alive
 class CNServer {
 protected:
     std::unordered_map<SOCKET, CNSocket*> connections;
     std::mutex activeCrit;
 
-    const size_t STARTFDSCOUNT = 8; // number of initial PollFD slots
-    std::vector<PollFD> fds;
+    EventLoop *eventLoop = nullptr;
+    std::vector<ReadyEvent> readyEvents;
+    std::vector<CNSocket*> flushQueue; // sockets with pending output
+    std::vector<CNSocket*> readQueue; // sockets that ran out of packet budget
+    std::vector<CNSocket*> readQueueTmp;
 
     std::string serverType = "invalid";
     SOCKET sock;
@@ -240,18 +285,27 @@ protected:
     bool active = true;
 
     void addPollFD(SOCKET s);
-    void removePollFD(int i);
+    void removePollFD(SOCKET s);
+    void flushConnections();
+    void stepReadQueue();
+
+    // how long the event loop may sleep when nothing happens on the sockets
+    virtual int waitTimeout();
 
 public:
     PacketHandler pHandler;
 
     CNServer();
     CNServer(uint16_t p);
+    virtual ~CNServer();
 
     void start();
     void kill();
+    void queueFlush(CNSocket *cns);
+    void queueRead(CNSocket *cns);
+    void setWritable(SOCKET s, bool writable);
     static void printPacket(CNPacketData *data);
-    virtual bool checkExtraSockets(int i);
+    virtual bool checkExtraSockets(SOCKET fd, int revents);
     virtual void newConnection(CNSocket* cns);
     virtual void killConnection(CNSocket* cns);
     virtual void onStep();
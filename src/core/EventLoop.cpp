@@ -0,0 +1,141 @@
+#include "core/EventLoop.hpp"
+
+#include "settings.hpp"
+
+#include <assert.h>
+
+EventLoop *EventLoop::create() {
+#ifdef __linux__
+    if (settings::EVENTBACKEND == "epoll") {
+        EpollEventLoop *loop = new EpollEventLoop();
+        if (loop->valid())
+            return loop;
+
+        printSocketError("epoll_create1");
+        std::cerr << "[WARN] OpenFusion: epoll unavailable, falling back to poll()" << std::endl;
+        delete loop;
+    }
+#endif
+
+    if (settings::EVENTBACKEND != "poll" && settings::EVENTBACKEND != "epoll")
+        std::cerr << "[WARN] OpenFusion: unknown event backend " << settings::EVENTBACKEND << ", using poll()" << std::endl;
+
+    return new PollEventLoop();
+}
+
+// ========================================================[[ PollEventLoop ]]========================================================
+
+void PollEventLoop::add(SOCKET fd) {
+    assert(indices.find(fd) == indices.end());
+
+    indices[fd] = fds.size();
+    fds.push_back({fd, POLLIN});
+}
+
+void PollEventLoop::remove(SOCKET fd) {
+    auto it = indices.find(fd);
+    assert(it != indices.end());
+
+    // swap with the last entry so removal doesn't shift the whole vector
+    size_t i = it->second;
+    indices.erase(it);
+
+    if (i != fds.size() - 1) {
+        fds[i] = fds.back();
+        indices[fds[i].fd] = i;
+    }
+    fds.pop_back();
+}
+
+void PollEventLoop::setWritable(SOCKET fd, bool writable) {
+    auto it = indices.find(fd);
+    assert(it != indices.end());
+
+    fds[it->second].events = writable ? (POLLIN | POLLOUT) : POLLIN;
+}
+
+int PollEventLoop::wait(std::vector<ReadyEvent>& out, int timeout) {
+    int n = poll(fds.data(), fds.size(), timeout);
+    if (SOCKETERROR(n))
+        return -1;
+
+    int ready = n;
+    for (size_t i = 0; i < fds.size() && n > 0; i++) {
+        if (fds[i].revents == 0)
+            continue;
+
+        n--;
+        out.push_back({fds[i].fd, fds[i].revents});
+    }
+
+    return ready;
+}
+
+// ========================================================[[ EpollEventLoop ]]========================================================
+
+#ifdef __linux__
+
+/*
+ * Sockets are registered level-triggered, since CNSocket::step() doesn't
+ * necessarily consume everything that's readable on a socket in one go.
+ */
+
+EpollEventLoop::EpollEventLoop() {
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+}
+
+EpollEventLoop::~EpollEventLoop() {
+    if (epfd >= 0)
+        close(epfd);
+}
+
+void EpollEventLoop::add(SOCKET fd) {
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        printSocketError("epoll_ctl");
+        std::cerr << "[FATAL] OpenFusion: failed to watch socket " << fd << std::endl;
+        terminate(0);
+    }
+}
+
+void EpollEventLoop::setWritable(SOCKET fd, bool writable) {
+    struct epoll_event ev = {};
+    ev.events = writable ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    ev.data.fd = fd;
+
+    if (epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev) < 0)
+        printSocketError("epoll_ctl");
+}
+
+void EpollEventLoop::remove(SOCKET fd) {
+    struct epoll_event ev = {}; // ignored, but must be non-NULL on old kernels
+    if (epoll_ctl(epfd, EPOLL_CTL_DEL, fd, &ev) < 0)
+        printSocketError("epoll_ctl");
+}
+
+int EpollEventLoop::wait(std::vector<ReadyEvent>& out, int timeout) {
+    int n = epoll_wait(epfd, events, EPOLL_MAX_EVENTS, timeout);
+    if (n < 0)
+        return -1;
+
+    for (int i = 0; i < n; i++) {
+        int revents = 0;
+        if (events[i].events & EPOLLIN)
+            revents |= POLLIN;
+        if (events[i].events & EPOLLOUT)
+            revents |= POLLOUT;
+        if (events[i].events & EPOLLERR)
+            revents |= POLLERR;
+        if (events[i].events & EPOLLHUP)
+            revents |= POLLHUP;
+
+        out.push_back({events[i].data.fd, revents});
+    }
+
+    return n;
+}
+
+#endif
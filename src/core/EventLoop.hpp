@@ -0,0 +1,75 @@
+#pragma once
+
+#include "core/CNProtocol.hpp"
+
+#include <vector>
+#include <unordered_map>
+
+/*
+ * Readiness notification backends for CNServer.
+ *
+ * poll() is always available and is used as the portable fallback.
+ * On Linux we prefer epoll, where the cost of a wakeup scales with the
+ * number of sockets that are actually ready instead of the total number
+ * of sockets being watched.
+ *
+ * Events are always reported using the poll() flags (POLLIN, POLLOUT,
+ * POLLERR, POLLHUP), regardless of the backend in use.
+ */
+
+class EventLoop {
+public:
+    virtual ~EventLoop() {}
+
+    virtual const char *name() = 0;
+    virtual void add(SOCKET fd) = 0;
+    virtual void remove(SOCKET fd) = 0;
+    // toggle interest in POLLOUT for a socket that was already added
+    virtual void setWritable(SOCKET fd, bool writable) = 0;
+
+    /*
+     * Blocks for at most timeout milliseconds and appends the ready sockets
+     * to out. Returns the number of ready sockets or -1 on error, with the
+     * platform's socket error left set (see OF_ERRNO).
+     */
+    virtual int wait(std::vector<ReadyEvent>& out, int timeout) = 0;
+
+    // instantiates the backend selected in the config, if it's supported
+    static EventLoop *create();
+};
+
+class PollEventLoop : public EventLoop {
+private:
+    std::vector<PollFD> fds;
+    std::unordered_map<SOCKET, size_t> indices; // fd -> position in fds
+
+public:
+    const char *name() { return "poll"; }
+    void add(SOCKET fd);
+    void remove(SOCKET fd);
+    void setWritable(SOCKET fd, bool writable);
+    int wait(std::vector<ReadyEvent>& out, int timeout);
+};
+
+#ifdef __linux__
+#include <sys/epoll.h>
+
+#define EPOLL_MAX_EVENTS 256
+
+class EpollEventLoop : public EventLoop {
+private:
+    int epfd;
+    struct epoll_event events[EPOLL_MAX_EVENTS];
+
+public:
+    EpollEventLoop();
+    ~EpollEventLoop();
+
+    const char *name() { return "epoll"; }
+    bool valid() { return epfd >= 0; }
+    void add(SOCKET fd);
+    void remove(SOCKET fd);
+    void setWritable(SOCKET fd, bool writable);
+    int wait(std::vector<ReadyEvent>& out, int timeout);
+};
+#endif
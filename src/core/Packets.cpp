@@ -1,15 +1,22 @@
 #include <string>
+#include <array>
 
 #include "Defines.hpp"
 #include "Packets.hpp"
 #include "CNStructs.hpp"
 
-#define PACKET(id) {id, {id, sizeof(s##id), #id}}
-#define MANUAL(id) {id, {id, sizeof(s##id), #id}}
-#define VAR_PACKET(id, memb, tr) {id, {id, sizeof(s##id), #id, offsetof(s##id, memb), sizeof(tr)}}
+#define PACKET(id) {id, PacketDesc(sizeof(s##id)), #id}
+#define MANUAL(id) {id, PacketDesc(sizeof(s##id)), #id}
+#define VAR_PACKET(id, memb, tr) {id, PacketDesc(sizeof(s##id), offsetof(s##id, memb), sizeof(tr)), #id}
+
+struct PacketEntry {
+    uint32_t id;
+    PacketDesc desc;
+    const char *name;
+};
 
 /*
- * This map defines descriptors for all packets, and is used by the new system
+ * This list defines descriptors for all packets, and is used by the new system
  * for validation. From now on, we have to convert new variadic packets from
  * PACKET to VAR_PACKET in this list to use them.
  *
@@ -18,7 +25,7 @@
  * will need to be manually validated and sent using the legacy sendPacket()
  * invocation pattern.
  */
-std::map<uint32_t, PacketDesc> Packets::packets = {
+static constexpr PacketEntry entries[] = {
     // CL2LS
     PACKET(P_CL2LS_REQ_LOGIN),
     PACKET(P_CL2LS_REQ_CHECK_CHAR_NAME),
@@ -235,7 +242,7 @@ std::map<uint32_t, PacketDesc> Packets::packets = {
     PACKET(P_FE2CL_REP_PC_EXIT_FAIL),
     PACKET(P_FE2CL_REP_PC_EXIT_SUCC),
     PACKET(P_FE2CL_PC_EXIT),
-    PACKET(P_FE2CL_PC_AROUND),
+    VAR_PACKET(P_FE2CL_PC_AROUND, iPCCnt, sPCAppearanceData),
     PACKET(P_FE2CL_PC_MOVE),
     PACKET(P_FE2CL_PC_STOP),
     PACKET(P_FE2CL_PC_JUMP),
@@ -243,9 +250,9 @@ std::map<uint32_t, PacketDesc> Packets::packets = {
     PACKET(P_FE2CL_NPC_EXIT),
     PACKET(P_FE2CL_NPC_MOVE),
     PACKET(P_FE2CL_NPC_NEW),
-    PACKET(P_FE2CL_NPC_AROUND),
-    PACKET(P_FE2CL_AROUND_DEL_PC),
-    PACKET(P_FE2CL_AROUND_DEL_NPC),
+    VAR_PACKET(P_FE2CL_NPC_AROUND, iNPCCnt, sNPCAppearanceData),
+    VAR_PACKET(P_FE2CL_AROUND_DEL_PC, iPCCnt, int32_t),
+    VAR_PACKET(P_FE2CL_AROUND_DEL_NPC, iNPCCnt, int32_t),
     PACKET(P_FE2CL_REP_SEND_FREECHAT_MESSAGE_SUCC),
     PACKET(P_FE2CL_REP_SEND_FREECHAT_MESSAGE_FAIL),
     VAR_PACKET(P_FE2CL_PC_ATTACK_NPCs_SUCC, iNPCCnt, sAttackResult),
@@ -387,8 +394,8 @@ std::map<uint32_t, PacketDesc> Packets::packets = {
     PACKET(P_FE2CL_TRANSPORTATION_EXIT),
     PACKET(P_FE2CL_TRANSPORTATION_MOVE),
     PACKET(P_FE2CL_TRANSPORTATION_NEW),
-    PACKET(P_FE2CL_TRANSPORTATION_AROUND),
-    PACKET(P_FE2CL_AROUND_DEL_TRANSPORTATION),
+    VAR_PACKET(P_FE2CL_TRANSPORTATION_AROUND, iCnt, sTransportationAppearanceData),
+    VAR_PACKET(P_FE2CL_AROUND_DEL_TRANSPORTATION, iCnt, int32_t),
     PACKET(P_FE2CL_REP_EP_RANK_LIST),
     PACKET(P_FE2CL_REP_EP_RANK_DETAIL),
     PACKET(P_FE2CL_REP_EP_RANK_PC_INFO),
@@ -404,8 +411,8 @@ std::map<uint32_t, PacketDesc> Packets::packets = {
     PACKET(P_FE2CL_SHINY_ENTER),
     PACKET(P_FE2CL_SHINY_EXIT),
     PACKET(P_FE2CL_SHINY_NEW),
-    PACKET(P_FE2CL_SHINY_AROUND),
-    PACKET(P_FE2CL_AROUND_DEL_SHINY),
+    VAR_PACKET(P_FE2CL_SHINY_AROUND, iShinyCnt, sShinyAppearanceData),
+    VAR_PACKET(P_FE2CL_AROUND_DEL_SHINY, iShinyCnt, int32_t),
     PACKET(P_FE2CL_REP_SHINY_PICKUP_FAIL),
     PACKET(P_FE2CL_REP_SHINY_PICKUP_SUCC),
     PACKET(P_FE2CL_PC_MOVETRANSPORTATION),
@@ -538,9 +545,35 @@ std::map<uint32_t, PacketDesc> Packets::packets = {
 #endif
 };
 
-std::string Packets::p2str(int val) {
-    if (packets.find(val) == packets.end())
+/*
+ * The entries are laid out into tables indexed by Packets::index() at
+ * compile time, so validating a packet is a single array access.
+ * An ID that doesn't fit in the table fails to compile here.
+ */
+template<typename T, typename F>
+static constexpr std::array<T, Packets::TABLE_SIZE> buildTable(F field) {
+    std::array<T, Packets::TABLE_SIZE> table = {};
+
+    for (const PacketEntry& entry : entries) {
+        int i = Packets::index(entry.id);
+        if (i < 0)
+            throw "packet ID doesn't fit in the descriptor table";
+
+        table[i] = field(entry);
+    }
+
+    return table;
+}
+
+constexpr std::array<PacketDesc, Packets::TABLE_SIZE> Packets::descs =
+    buildTable<PacketDesc>([](const PacketEntry& e) { return e.desc; });
+constexpr std::array<const char*, Packets::TABLE_SIZE> Packets::names =
+    buildTable<const char*>([](const PacketEntry& e) { return e.name; });
+
+const char *Packets::p2str(uint32_t val) {
+    int i = index(val);
+    if (i < 0 || names[i] == nullptr)
         return "UNKNOWN";
 
-    return packets[val].name;
+    return names[i];
 }
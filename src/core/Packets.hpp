@@ -2,44 +2,37 @@
 
 #include "CNStructs.hpp"
 
-#include <map>
+#include <array>
+
+
+/*
+ * Packet IDs are made up of a direction (ex. CL2FE) in the upper byte and a
+ * sequence number in the lower bits, so every packet we know of can be
+ * given a slot in a small, dense table.
+ */
+#define PACKET_TABLE_SLOTS 0x200 // per direction; must exceed every N_* count
+
+// a few packets the client doesn't implement share this ID
+#define PACKET_ID_PLACEHOLDER 0x7fffffff
 
 // Packet Descriptor
 struct PacketDesc {
-        uint32_t val;
-        std::string name;
-        size_t size;
-        bool variadic;
-        size_t cntMembOfs;
-        size_t trailerSize;
-
-        PacketDesc() {}
-
-        PacketDesc(const PacketDesc& other) {
-            val = other.val;
-            name = other.name;
-            size = other.size;
-            variadic = other.variadic;
-            cntMembOfs = other.cntMembOfs;
-            trailerSize = other.trailerSize;
-        }
+    bool valid;
+    bool variadic;
+    uint32_t size;
+    uint32_t cntMembOfs;
+    uint32_t trailerSize;
 
-        PacketDesc(PacketDesc&& other) {
-            val = other.val;
-            name = std::move(other.name);
-            size = other.size;
-            variadic = other.variadic;
-            cntMembOfs = other.cntMembOfs;
-            trailerSize = other.trailerSize;
-        }
+    constexpr PacketDesc() :
+        valid(false), variadic(false), size(0), cntMembOfs(0), trailerSize(0) {}
 
-        // non-variadic constructor
-        PacketDesc(uint32_t v, size_t s, std::string n) :
-            val(v), name(n), size(s), variadic(false) {}
+    // non-variadic constructor
+    constexpr PacketDesc(size_t s) :
+        valid(true), variadic(false), size(s), cntMembOfs(0), trailerSize(0) {}
 
-        // variadic constructor
-        PacketDesc(uint32_t v, size_t s, std::string n, size_t ofs, size_t ts) :
-            val(v), name(n), size(s), variadic(true), cntMembOfs(ofs), trailerSize(ts) {}
+    // variadic constructor
+    constexpr PacketDesc(size_t s, size_t ofs, size_t ts) :
+        valid(true), variadic(true), size(s), cntMembOfs(ofs), trailerSize(ts) {}
 };
 
 /*
@@ -57,7 +50,46 @@ struct sSkillResult_Leech {
 };
 
 namespace Packets {
-    extern std::map<uint32_t, PacketDesc> packets;
+    enum {
+        TABLE_CL2LS,
+        TABLE_CL2FE,
+        TABLE_LS2CL,
+        TABLE_FE2CL,
+        TABLE_DIRECTIONS
+    };
+
+    // the placeholder ID gets the very last slot
+    const size_t TABLE_SIZE = TABLE_DIRECTIONS * PACKET_TABLE_SLOTS + 1;
+
+    // returns the table slot for a packet ID, or -1 if it can't have one
+    inline constexpr int index(uint32_t id) {
+        if (id == PACKET_ID_PLACEHOLDER)
+            return TABLE_SIZE - 1;
+
+        uint32_t seq = id & 0x00ffffff;
+        if (seq >= PACKET_TABLE_SLOTS)
+            return -1;
+
+        switch (id & 0xff000000) {
+        case CL2LS: return TABLE_CL2LS * PACKET_TABLE_SLOTS + seq;
+        case CL2FE: return TABLE_CL2FE * PACKET_TABLE_SLOTS + seq;
+        case LS2CL: return TABLE_LS2CL * PACKET_TABLE_SLOTS + seq;
+        case FE2CL: return TABLE_FE2CL * PACKET_TABLE_SLOTS + seq;
+        default: return -1;
+        }
+    }
+
+    extern const std::array<PacketDesc, TABLE_SIZE> descs;
+    extern const std::array<const char*, TABLE_SIZE> names; // kept apart from the hot descriptors
+
+    // returns nullptr for unknown packets
+    inline const PacketDesc *getDesc(uint32_t id) {
+        int i = index(id);
+        if (i < 0 || !descs[i].valid)
+            return nullptr;
+
+        return &descs[i];
+    }
 
-    std::string p2str(int val);
+    const char *p2str(uint32_t val);
 }
@@ -46,8 +46,8 @@ namespace Database {
     void close();
 
     void findAccount(Account* account, std::string login);
-    // returns ID, 0 if something failed
-    int addAccount(std::string login, std::string password);
+    // takes an already hashed password; returns ID, 0 if something failed
+    int addAccount(std::string login, std::string passwordHash);
 
     // interface for the /ban command
     bool banPlayer(int playerId, std::string& reason);
@@ -81,6 +81,16 @@ namespace Database {
     // getting players
     void getPlayer(Player* plr, int id);
     bool _updatePlayer(Player *player);
+
+    /*
+     * Saving players; these only take a copy of them, the actual writes
+     * happen in the background. See db/writer.cpp.
+     */
+    void startWriter();
+    void stopWriter();
+    void queuePlayerSave(Player *player);
+    void flushPlayerSaves(); // writes everything queued since the last flush in one go
+    void waitForPlayerSaves();
     void updatePlayer(Player *player);
     void commitTrade(Player *plr1, Player *plr2);
     
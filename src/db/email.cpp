@@ -10,12 +10,12 @@ int Database::getUnreadEmailCount(int playerID) {
         WHERE PlayerID = ? AND ReadFlag = 0;
         )";
     sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, playerID);
     sqlite3_step(stmt);
     int ret = sqlite3_column_int(stmt, 0);
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
     return ret;
 }
@@ -37,7 +37,7 @@ std::vector<EmailData> Database::getEmails(int playerID, int page) {
         OFFSET ?;
         )";
     sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, playerID);
     int offset = 5 * page - 5;
     sqlite3_bind_int(stmt, 2, offset);
@@ -58,7 +58,7 @@ std::vector<EmailData> Database::getEmails(int playerID, int page) {
 
         emails.push_back(toAdd);
     }
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
     return emails;
 }
@@ -75,14 +75,14 @@ EmailData Database::getEmail(int playerID, int index) {
         WHERE PlayerID = ? AND MsgIndex = ?;
         )";
     sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, playerID);
     sqlite3_bind_int(stmt, 2, index);
 
     EmailData result;
     if (sqlite3_step(stmt) != SQLITE_ROW) {
         std::cout << "[WARN] Database: Email not found!" << std::endl;
-        sqlite3_finalize(stmt);
+        releaseStatement(stmt);
         return result;
     }
 
@@ -99,7 +99,7 @@ EmailData Database::getEmail(int playerID, int index) {
     result.SendTime = sqlite3_column_int64(stmt, 8);
     result.DeleteTime = sqlite3_column_int64(stmt, 9);
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
     return result;
 }
 
@@ -116,7 +116,7 @@ sItemBase* Database::getEmailAttachments(int playerID, int index) {
         WHERE PlayerID = ? AND MsgIndex = ?;
         )";
     sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, playerID);
     sqlite3_bind_int(stmt, 2, index);
 
@@ -133,7 +133,7 @@ sItemBase* Database::getEmailAttachments(int playerID, int index) {
         items[slot].iTimeLimit = sqlite3_column_int(stmt, 4);
     }
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
     return items;
 }
 
@@ -146,7 +146,7 @@ void Database::updateEmailContent(EmailData* data) {
         WHERE PlayerID = ? AND MsgIndex = ?;
         )";
     sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, data->PlayerId);
     sqlite3_bind_int(stmt, 2, data->MsgIndex);
     sqlite3_step(stmt);
@@ -155,7 +155,7 @@ void Database::updateEmailContent(EmailData* data) {
     // set attachment flag dynamically
     data->ItemFlag = (data->Taros > 0 || attachmentsCount > 0) ? 1 : 0;
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
     sql = R"(
         UPDATE EmailData
@@ -174,7 +174,7 @@ void Database::updateEmailContent(EmailData* data) {
             DeleteTime = ?
         WHERE PlayerID = ? AND MsgIndex = ?;
         )";
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, data->PlayerId);
     sqlite3_bind_int(stmt, 2, data->MsgIndex);
     sqlite3_bind_int(stmt, 3, data->ReadFlag);
@@ -193,7 +193,7 @@ void Database::updateEmailContent(EmailData* data) {
     if (sqlite3_step(stmt) != SQLITE_DONE)
         std::cout << "[WARN] Database: failed to update email: " << sqlite3_errmsg(db) << std::endl;
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 }
 
 void Database::deleteEmailAttachments(int playerID, int index, int slot) {
@@ -201,16 +201,18 @@ void Database::deleteEmailAttachments(int playerID, int index, int slot) {
 
     sqlite3_stmt* stmt;
 
-    std::string sql(R"(
+    const char* sql = R"(
         DELETE FROM EmailItems
         WHERE PlayerID = ? AND MsgIndex = ?;
-        )");
+        )";
 
     if (slot != -1)
-        sql += " AND \"Slot\" = ? ";
-    sql += ";";
+        sql = R"(
+            DELETE FROM EmailItems
+            WHERE PlayerID = ? AND MsgIndex = ? AND "Slot" = ?;
+            )";
 
-    sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, playerID);
     sqlite3_bind_int(stmt, 2, index);
     if (slot != -1)
@@ -218,7 +220,7 @@ void Database::deleteEmailAttachments(int playerID, int index, int slot) {
 
     if (sqlite3_step(stmt) != SQLITE_DONE)
         std::cout << "[WARN] Database: Failed to delete email attachments: " << sqlite3_errmsg(db) << std::endl;
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 }
 
 void Database::deleteEmails(int playerID, int64_t* indices) {
@@ -231,7 +233,7 @@ void Database::deleteEmails(int playerID, int64_t* indices) {
         DELETE FROM EmailData
         WHERE PlayerID = ? AND MsgIndex = ?;
         )";
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
 
     for (int i = 0; i < 5; i++) {
         sqlite3_bind_int(stmt, 1, playerID);
@@ -241,7 +243,7 @@ void Database::deleteEmails(int playerID, int64_t* indices) {
         }
         sqlite3_reset(stmt);
     }
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
     sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
 }
@@ -257,16 +259,17 @@ int Database::getNextEmailIndex(int playerID) {
         LIMIT 1;
         )";
     sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, playerID);
     sqlite3_step(stmt);
     int index = sqlite3_column_int(stmt, 0);
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
     return (index > 0 ? index + 1 : 1);
 }
 
 bool Database::sendEmail(EmailData* data, std::vector<sItemBase> attachments, Player *sender) {
+    waitForPlayerSaves(); // an older queued save of the sender mustn't land after this one
     std::lock_guard<std::mutex> lock(dbCrit);
 
     sqlite3_exec(db, "BEGIN TRANSACTION;", NULL, NULL, NULL);
@@ -280,7 +283,7 @@ bool Database::sendEmail(EmailData* data, std::vector<sItemBase> attachments, Pl
         )";
     sqlite3_stmt* stmt;
 
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, data->PlayerId);
     sqlite3_bind_int(stmt, 2, data->MsgIndex);
     sqlite3_bind_int(stmt, 3, data->ReadFlag);
@@ -297,11 +300,11 @@ bool Database::sendEmail(EmailData* data, std::vector<sItemBase> attachments, Pl
     if (sqlite3_step(stmt) != SQLITE_DONE) {
         std::cout << "[WARN] Database: Failed to send email: " << sqlite3_errmsg(db) << std::endl;
         sqlite3_exec(db, "ROLLBACK TRANSACTION;", NULL, NULL, NULL);
-        sqlite3_finalize(stmt);
+        releaseStatement(stmt);
         return false;
     }
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
     sql = R"(
         INSERT INTO EmailItems
@@ -309,7 +312,7 @@ bool Database::sendEmail(EmailData* data, std::vector<sItemBase> attachments, Pl
         VALUES (?, ?, ?, ?, ?, ?, ?);
         )";
 
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
 
     // send attachments
     int slot = 1;
@@ -325,12 +328,12 @@ bool Database::sendEmail(EmailData* data, std::vector<sItemBase> attachments, Pl
         if (sqlite3_step(stmt) != SQLITE_DONE) {
             std::cout << "[WARN] Database: Failed to send email: " << sqlite3_errmsg(db) << std::endl;
             sqlite3_exec(db, "ROLLBACK TRANSACTION;", NULL, NULL, NULL);
-            sqlite3_finalize(stmt);
+            releaseStatement(stmt);
             return false;
         }
         sqlite3_reset(stmt);
     }
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
     if (!_updatePlayer(sender)) {
         std::cout << "[WARN] Database: Failed to save player to database: " << sqlite3_errmsg(db) << std::endl;
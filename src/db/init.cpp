@@ -5,10 +5,39 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <unordered_map>
+#include <algorithm>
 
 std::mutex dbCrit;
 sqlite3 *db;
 
+static std::unordered_map<const char*, sqlite3_stmt*> statements;
+
+sqlite3_stmt *getStatement(const char *sql) {
+    auto it = statements.find(sql);
+    if (it != statements.end()) {
+        // in case the last user bailed out without releasing it
+        sqlite3_reset(it->second);
+        sqlite3_clear_bindings(it->second);
+        return it->second;
+    }
+
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v3(db, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, NULL) != SQLITE_OK) {
+        std::cout << "[WARN] Database: Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        return nullptr;
+    }
+
+    statements[sql] = stmt;
+    return stmt;
+}
+
+void releaseStatement(sqlite3_stmt *stmt) {
+    // resetting also ends any read transaction the statement was holding open
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+}
+
 /*
  * When migrating from DB version 3 to 4, we change the username column
  * to be case-insensitive. This function ensures there aren't any
@@ -165,6 +194,8 @@ static void checkMetaTable() {
     } else if (dbVersion < DATABASE_VERSION) {
         // we're gonna migrate; back up the DB
         std::cout << "[INFO] Backing up database" << std::endl;
+        // move anything still in the WAL into the file we're about to copy
+        sqlite3_exec(db, "PRAGMA wal_checkpoint(TRUNCATE);", NULL, NULL, NULL);
         // copy db file over using binary streams
         std::ifstream  src(settings::DBPATH, std::ios::binary);
         std::ofstream  dst(settings::DBPATH + ".old." + std::to_string(dbVersion), std::ios::binary);
@@ -203,6 +234,48 @@ static void checkMetaTable() {
     }    
 }
 
+// runs a pragma and returns the value it reports back, if any
+static std::string pragma(std::string sql) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, NULL) != SQLITE_OK) {
+        std::cout << "[WARN] Database: Failed to run " << sql << ": " << sqlite3_errmsg(db) << std::endl;
+        return "";
+    }
+
+    std::string result = "";
+    if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_text(stmt, 0) != NULL)
+        result = std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
+
+    sqlite3_finalize(stmt);
+    return result;
+}
+
+/*
+ * Durability and caching profile, from the config.
+ *
+ * With the WAL journal, a commit only appends to the -wal file, and with
+ * synchronous=NORMAL it is only synced to disk when the WAL is checkpointed
+ * back into the database. A power loss can then cost the last few commits,
+ * but can't corrupt the database.
+ */
+static void applyPragmas() {
+    // must come first; can't be changed once the database has content in WAL mode
+    pragma("PRAGMA page_size=" + std::to_string(settings::DBPAGESIZE) + ";");
+
+    // sqlite reports the mode it ended up in, in lowercase
+    std::string wanted = settings::DBJOURNAL;
+    std::transform(wanted.begin(), wanted.end(), wanted.begin(), ::tolower);
+    std::string journal = pragma("PRAGMA journal_mode=" + wanted + ";");
+    if (journal != wanted)
+        std::cout << "[WARN] Database: Couldn't switch to " << wanted
+            << " journal mode, using " << journal << std::endl;
+
+    pragma("PRAGMA synchronous=" + settings::DBSYNC + ";");
+    // negative values are in KiB rather than pages
+    pragma("PRAGMA cache_size=-" + std::to_string(settings::DBCACHESIZE) + ";");
+    pragma("PRAGMA mmap_size=" + std::to_string((int64_t)settings::DBMMAPSIZE * 1024 * 1024) + ";");
+}
+
 static void createTables() {
     std::ifstream file("sql/tables.sql");
     if (!file.is_open()) {
@@ -261,6 +334,8 @@ void Database::open() {
     // foreign keys in sqlite are off by default; enable them
     sqlite3_exec(db, "PRAGMA foreign_keys=ON;", NULL, NULL, NULL);
 
+    applyPragmas();
+
     // just in case a DB operation collides with an external manual modification
     sqlite3_busy_timeout(db, 2000);
 
@@ -282,8 +357,16 @@ void Database::open() {
             message += "s";
     }
     std::cout << message << std::endl;
+
+    startWriter();
 }
 
 void Database::close() {
+    stopWriter();
+
+    for (auto& pair : statements)
+        sqlite3_finalize(pair.second);
+    statements.clear();
+
     sqlite3_close(db);
 }
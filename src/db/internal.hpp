@@ -15,4 +15,17 @@
 extern std::mutex dbCrit;
 extern sqlite3 *db;
 
+/*
+ * Statements are only compiled the first time a call site uses them, then
+ * kept around for as long as the database is open. They're keyed by the
+ * address of the SQL text, so it must be a string literal.
+ *
+ * Hand statements back with releaseStatement() instead of finalizing them.
+ */
+sqlite3_stmt *getStatement(const char *sql);
+void releaseStatement(sqlite3_stmt *stmt);
+
+// the next save of this player will rewrite all of their rows
+void forgetSavedRows(int playerID);
+
 using namespace Database;
@@ -1,7 +1,5 @@
 #include "db/internal.hpp"
 
-#include "bcrypt/BCrypt.hpp"
-
 void Database::findAccount(Account* account, std::string login) {
     std::lock_guard<std::mutex> lock(dbCrit);
 
@@ -13,7 +11,7 @@ void Database::findAccount(Account* account, std::string login) {
         )";
     sqlite3_stmt* stmt;
 
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_text(stmt, 1, login.c_str(), -1, NULL);
 
     int rc = sqlite3_step(stmt);
@@ -24,10 +22,10 @@ void Database::findAccount(Account* account, std::string login) {
         account->BannedUntil = sqlite3_column_int64(stmt, 3);
         account->BanReason = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
     }
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 }
 
-int Database::addAccount(std::string login, std::string password) {
+int Database::addAccount(std::string login, std::string passwordHash) {
     std::lock_guard<std::mutex> lock(dbCrit);
 
     const char* sql = R"(
@@ -36,14 +34,13 @@ int Database::addAccount(std::string login, std::string password) {
         )";
     sqlite3_stmt* stmt;
 
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_text(stmt, 1, login.c_str(), -1, NULL);
-    std::string hashedPassword = BCrypt::generateHash(password);
-    sqlite3_bind_text(stmt, 2, hashedPassword.c_str(), -1, NULL);
+    sqlite3_bind_text(stmt, 2, passwordHash.c_str(), -1, NULL);
     sqlite3_bind_int(stmt, 3, settings::ACCLEVEL);
 
     int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
     if (rc != SQLITE_DONE) {
         std::cout << "[WARN] Database: failed to add new account" << std::endl;
         return 0;
@@ -69,11 +66,11 @@ void Database::updateSelected(int accountId, int slot) {
 
     sqlite3_stmt* stmt;
 
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, slot);
     sqlite3_bind_int(stmt, 2, accountId);
     int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
     if (rc != SQLITE_DONE)
         std::cout << "[WARN] Database fail on updateSelected(): " << sqlite3_errmsg(db) << std::endl;
@@ -92,11 +89,11 @@ void Database::updateSelectedByPlayerId(int accountId, int32_t playerId) {
 
     sqlite3_stmt* stmt;
 
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, playerId);
     sqlite3_bind_int(stmt, 2, accountId);
     int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
     if (rc != SQLITE_DONE)
         std::cout << "[WARN] Database fail on updateSelectedByPlayerId(): " << sqlite3_errmsg(db) << std::endl;
@@ -114,13 +111,13 @@ bool Database::validateCharacter(int characterID, int userID) {
         )";
     sqlite3_stmt* stmt;
 
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, characterID);
     sqlite3_bind_int(stmt, 2, userID);
     int rc = sqlite3_step(stmt);
     // if we got a row back, the character is valid
     bool result = (rc == SQLITE_ROW);
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
     return result;
 }
 
@@ -135,13 +132,13 @@ bool Database::isNameFree(std::string firstName, std::string lastName) {
         )";
     sqlite3_stmt* stmt;
 
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_text(stmt, 1, firstName.c_str(), -1, NULL);
     sqlite3_bind_text(stmt, 2, lastName.c_str(),  -1, NULL);
     int rc = sqlite3_step(stmt);
 
     bool result = (rc == SQLITE_ROW && sqlite3_column_int(stmt, 0) == 0);
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
     return result;
 }
 
@@ -161,13 +158,13 @@ bool Database::isSlotFree(int accountId, int slotNum) {
         )";
     sqlite3_stmt* stmt;
 
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, accountId);
     sqlite3_bind_int(stmt, 2, slotNum);
     int rc = sqlite3_step(stmt);
 
     bool result = (rc == SQLITE_ROW && sqlite3_column_int(stmt, 0) == 0);
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
     return result;
 }
 
@@ -187,7 +184,7 @@ int Database::createCharacter(sP_CL2LS_REQ_SAVE_CHAR_NAME* save, int AccountID)
     std::string firstName = AUTOU16TOU8(save->szFirstName);
     std::string lastName =  AUTOU16TOU8(save->szLastName);
 
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, AccountID);
     sqlite3_bind_int(stmt, 2, save->iSlotNum);
     sqlite3_bind_text(stmt, 3, firstName.c_str(), -1, NULL);
@@ -209,24 +206,24 @@ int Database::createCharacter(sP_CL2LS_REQ_SAVE_CHAR_NAME* save, int AccountID)
     sqlite3_bind_blob(stmt, 13, blobBuffer, sizeof(Player::iFirstUseFlag), NULL);
 
     if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
+        releaseStatement(stmt);
         sqlite3_exec(db, "ROLLBACK TRANSACTION;", NULL, NULL, NULL);
         return 0;
     }
 
     int playerId = sqlite3_last_insert_rowid(db);
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
     sql = R"(
         INSERT INTO Appearances (PlayerID)
         VALUES (?);
         )";
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, playerId);
 
     int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
     if (rc != SQLITE_DONE) {
         sqlite3_exec(db, "ROLLBACK TRANSACTION;", NULL, NULL, NULL);
         return 0;
@@ -248,17 +245,17 @@ bool Database::finishCharacter(sP_CL2LS_REQ_CHAR_CREATE* character, int accountI
         )";
     sqlite3_stmt* stmt;
 
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, character->PCStyle.iPC_UID);
     sqlite3_bind_int(stmt, 2, accountId);
 
     if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
+        releaseStatement(stmt);
         sqlite3_exec(db, "ROLLBACK TRANSACTION;", NULL, NULL, NULL);
         return false;
     }
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
     sql = R"(
         UPDATE Appearances
@@ -273,7 +270,7 @@ bool Database::finishCharacter(sP_CL2LS_REQ_CHAR_CREATE* character, int accountI
             SkinColor = ?
         WHERE PlayerID = ?;
         )";
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
 
     sqlite3_bind_int(stmt, 1, character->PCStyle.iBody);
     sqlite3_bind_int(stmt, 2, character->PCStyle.iEyeColor);
@@ -286,18 +283,18 @@ bool Database::finishCharacter(sP_CL2LS_REQ_CHAR_CREATE* character, int accountI
     sqlite3_bind_int(stmt, 9, character->PCStyle.iPC_UID);
 
     if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
+        releaseStatement(stmt);
         sqlite3_exec(db, "ROLLBACK TRANSACTION;", NULL, NULL, NULL);
         return false;
     }
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
     sql = R"(
         INSERT INTO Inventory (PlayerID, Slot, ID, Type, Opt)
         VALUES (?, ?, ?, ?, 1);
         )";
-    sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
+    stmt = getStatement(sql);
 
     int items[3] = { character->sOn_Item.iEquipUBID, character->sOn_Item.iEquipLBID, character->sOn_Item.iEquipFootID };
     for (int i = 0; i < 3; i++) {
@@ -307,19 +304,20 @@ bool Database::finishCharacter(sP_CL2LS_REQ_CHAR_CREATE* character, int accountI
         sqlite3_bind_int(stmt, 4, i+1);
 
         if (sqlite3_step(stmt) != SQLITE_DONE) {
-            sqlite3_finalize(stmt);
+            releaseStatement(stmt);
             sqlite3_exec(db, "ROLLBACK TRANSACTION;", NULL, NULL, NULL);
             return false;
         }
         sqlite3_reset(stmt);
     }
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
     sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
     return true;
 }
 
 bool Database::finishTutorial(int playerID, int accountID) {
+    waitForPlayerSaves(); // the tutorial may have only just been saved
     std::lock_guard<std::mutex> lock(dbCrit);
 
     sqlite3_exec(db, "BEGIN TRANSACTION;", NULL, NULL, NULL);
@@ -332,7 +330,7 @@ bool Database::finishTutorial(int playerID, int accountID) {
         WHERE PlayerID = ? AND AccountID = ? AND TutorialFlag = 0;
         )";
     sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
 
     unsigned char questBuffer[128] = { 0 };
 
@@ -350,12 +348,12 @@ bool Database::finishTutorial(int playerID, int accountID) {
     sqlite3_bind_int(stmt, 4, accountID);
 
     if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
+        releaseStatement(stmt);
         sqlite3_exec(db, "ROLLBACK TRANSACTION;", NULL, NULL, NULL);
         return false;
     }
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
 #ifndef ACADEMY
     // Lightning Gun
@@ -364,17 +362,17 @@ bool Database::finishTutorial(int playerID, int accountID) {
             (PlayerID, Slot, ID, Type, Opt)
         VALUES (?, 0, 328, 0, 1);
         )";
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
 
     sqlite3_bind_int(stmt, 1, playerID);
 
     if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
+        releaseStatement(stmt);
         sqlite3_exec(db, "ROLLBACK TRANSACTION;", NULL, NULL, NULL);
         return false;
     }
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
     // Nano Buttercup
     sql = R"(
@@ -382,12 +380,12 @@ bool Database::finishTutorial(int playerID, int accountID) {
             (PlayerID, ID, Skill)
         VALUES (?, 1, 1);
         )";
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
 
     sqlite3_bind_int(stmt, 1, playerID);
 
     int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
     if (rc != SQLITE_DONE) {
         sqlite3_exec(db, "ROLLBACK TRANSACTION;", NULL, NULL, NULL);
@@ -396,10 +394,12 @@ bool Database::finishTutorial(int playerID, int accountID) {
 #endif
 
     sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
+    forgetSavedRows(playerID);
     return true;
 }
 
 int Database::deleteCharacter(int characterID, int userID) {
+    waitForPlayerSaves(); // so a late save doesn't bring anything back
     std::lock_guard<std::mutex> lock(dbCrit);
 
     const char* sql = R"(
@@ -411,34 +411,36 @@ int Database::deleteCharacter(int characterID, int userID) {
 
     sqlite3_stmt* stmt;
 
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, userID);
     sqlite3_bind_int(stmt, 2, characterID);
     if (sqlite3_step(stmt) != SQLITE_ROW) {
-        sqlite3_finalize(stmt);
+        releaseStatement(stmt);
         return 0;
     }
     int slot = sqlite3_column_int(stmt, 0);
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
     sql = R"(
         DELETE FROM Players
         WHERE AccountID = ? AND PlayerID = ?;
         )";
-    sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, userID);
     sqlite3_bind_int(stmt, 2, characterID);
     int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
     if (rc != SQLITE_DONE)
         return 0;
 
+    forgetSavedRows(characterID);
     return slot;
 }
 
 void Database::getCharInfo(std::vector <sP_LS2CL_REP_CHAR_INFO>* result, int userID) {
+    waitForPlayerSaves(); // they may have only just left the shard
     std::lock_guard<std::mutex> lock(dbCrit);
 
     const char* sql = R"(
@@ -452,7 +454,7 @@ void Database::getCharInfo(std::vector <sP_LS2CL_REP_CHAR_INFO>* result, int use
         )";
     sqlite3_stmt* stmt;
 
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, userID);
 
     while (sqlite3_step(stmt) == SQLITE_ROW) {
@@ -491,7 +493,7 @@ void Database::getCharInfo(std::vector <sP_LS2CL_REP_CHAR_INFO>* result, int use
             )";
         sqlite3_stmt* stmt2;
 
-        sqlite3_prepare_v2(db, sql2, -1, &stmt2, NULL);
+        stmt2 = getStatement(sql2);
         sqlite3_bind_int(stmt2, 1, toAdd.sPC_Style.iPC_UID);
         sqlite3_bind_int(stmt2, 2, AEQUIP_COUNT);
 
@@ -502,11 +504,11 @@ void Database::getCharInfo(std::vector <sP_LS2CL_REP_CHAR_INFO>* result, int use
             item->iOpt = sqlite3_column_int(stmt2, 3);
             item->iTimeLimit = sqlite3_column_int(stmt2, 4);
         }
-        sqlite3_finalize(stmt2);
+        releaseStatement(stmt2);
 
         result->push_back(toAdd);
     }
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 }
 
 // NOTE: This is currently never called.
@@ -519,13 +521,13 @@ void Database::evaluateCustomName(int characterID, CustomName decision) {
         WHERE PlayerID = ?;
         )";
     sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, int(decision));
     sqlite3_bind_int(stmt, 2, characterID);
 
     if (sqlite3_step(stmt) != SQLITE_DONE)
         std::cout << "[WARN] Database: Failed to update nameCheck: " << sqlite3_errmsg(db) << std::endl;
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 }
 
 bool Database::changeName(sP_CL2LS_REQ_CHANGE_CHAR_NAME* save, int accountId) {
@@ -540,7 +542,7 @@ bool Database::changeName(sP_CL2LS_REQ_CHANGE_CHAR_NAME* save, int accountId) {
         WHERE PlayerID = ? AND AccountID = ?;
         )";
     sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
 
     std::string firstName = AUTOU16TOU8(save->szFirstName);
     std::string lastName = AUTOU16TOU8(save->szLastName);
@@ -554,6 +556,6 @@ bool Database::changeName(sP_CL2LS_REQ_CHANGE_CHAR_NAME* save, int accountId) {
     sqlite3_bind_int(stmt, 5, accountId);
 
     int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
     return rc == SQLITE_DONE;
 }
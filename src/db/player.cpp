@@ -1,7 +1,231 @@
 #include "db/internal.hpp"
 
+#include <unordered_map>
+
 // Loading and saving players to/from the DB
 
+/*
+ * What the DB holds for each player's inventory, nanos and running quests,
+ * as of their last save, so that saves only need to touch the rows that
+ * changed since. Compared against a copy of the DB's rows rather than being
+ * marked dirty by the game logic, since there is no single place the latter
+ * modifies these from.
+ *
+ * Only accessed with dbCrit locked. Must be forgotten whenever anything
+ * other than _updatePlayer() may have modified the rows, or whenever the
+ * transaction that saved them is rolled back.
+ */
+struct SavedRows {
+    sItemBase items[AEQUIP_COUNT + AINVEN_COUNT + ABANK_COUNT]; // same order as the Slot column
+    sItemBase qitems[AQINVEN_COUNT];
+    sNano nanos[NANO_COUNT];
+    int tasks[ACTIVE_MISSION_COUNT];
+    int remaining[ACTIVE_MISSION_COUNT][3];
+};
+
+static std::unordered_map<int, SavedRows> savedRows;
+
+void forgetSavedRows(int playerID) {
+    savedRows.erase(playerID);
+}
+
+static bool sameItem(const sItemBase& a, const sItemBase& b) {
+    if (a.iID == 0 && b.iID == 0)
+        return true;
+
+    return a.iID == b.iID && a.iType == b.iType && a.iOpt == b.iOpt && a.iTimeLimit == b.iTimeLimit;
+}
+
+static bool sameNano(const sNano& a, const sNano& b) {
+    return a.iID == b.iID && a.iSkillID == b.iSkillID && a.iStamina == b.iStamina;
+}
+
+// steps a statement that doesn't return rows, then readies it for the next use
+static bool stepDone(sqlite3_stmt *stmt) {
+    int rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    return rc == SQLITE_DONE;
+}
+
+// wipes the rows that are saved piecemeal, for a full rewrite
+static bool clearRows(int playerID) {
+    const char* sqls[] = {
+        "DELETE FROM Inventory WHERE PlayerID = ?;",
+        "DELETE FROM QuestItems WHERE PlayerID = ?;",
+        "DELETE FROM Nanos WHERE PlayerID = ?;",
+        "DELETE FROM RunningQuests WHERE PlayerID = ?;"
+    };
+
+    for (const char* sql : sqls) {
+        sqlite3_stmt* stmt = getStatement(sql);
+        sqlite3_bind_int(stmt, 1, playerID);
+        bool ok = stepDone(stmt);
+        releaseStatement(stmt);
+
+        if (!ok)
+            return false;
+    }
+
+    return true;
+}
+
+static bool saveItems(int playerID, const SavedRows& old, const SavedRows& rows) {
+    const char* delItem = R"(
+        DELETE FROM Inventory WHERE PlayerID = ? AND Slot = ?;
+        )";
+    const char* putItem = R"(
+        INSERT INTO Inventory
+            (PlayerID, Slot, Type, Opt, ID, Timelimit)
+        VALUES (?, ?, ?, ?, ?, ?)
+        ON CONFLICT (PlayerID, Slot) DO UPDATE SET
+            Type = excluded.Type, Opt = excluded.Opt,
+            ID = excluded.ID, Timelimit = excluded.Timelimit;
+        )";
+    const char* delQItem = R"(
+        DELETE FROM QuestItems WHERE PlayerID = ? AND Slot = ?;
+        )";
+    const char* putQItem = R"(
+        INSERT INTO QuestItems (PlayerID, Slot, Opt, ID)
+        VALUES (?, ?, ?, ?)
+        ON CONFLICT (PlayerID, Slot) DO UPDATE SET
+            Opt = excluded.Opt, ID = excluded.ID;
+        )";
+
+    for (int i = 0; i < AEQUIP_COUNT + AINVEN_COUNT + ABANK_COUNT; i++) {
+        const sItemBase& item = rows.items[i];
+        if (sameItem(old.items[i], item))
+            continue;
+
+        sqlite3_stmt* stmt = getStatement(item.iID == 0 ? delItem : putItem);
+        sqlite3_bind_int(stmt, 1, playerID);
+        sqlite3_bind_int(stmt, 2, i);
+        if (item.iID != 0) {
+            sqlite3_bind_int(stmt, 3, item.iType);
+            sqlite3_bind_int(stmt, 4, item.iOpt);
+            sqlite3_bind_int(stmt, 5, item.iID);
+            sqlite3_bind_int(stmt, 6, item.iTimeLimit);
+        }
+
+        bool ok = stepDone(stmt);
+        releaseStatement(stmt);
+        if (!ok)
+            return false;
+    }
+
+    for (int i = 0; i < AQINVEN_COUNT; i++) {
+        const sItemBase& item = rows.qitems[i];
+        if (sameItem(old.qitems[i], item))
+            continue;
+
+        sqlite3_stmt* stmt = getStatement(item.iID == 0 ? delQItem : putQItem);
+        sqlite3_bind_int(stmt, 1, playerID);
+        sqlite3_bind_int(stmt, 2, i);
+        if (item.iID != 0) {
+            sqlite3_bind_int(stmt, 3, item.iOpt);
+            sqlite3_bind_int(stmt, 4, item.iID);
+        }
+
+        bool ok = stepDone(stmt);
+        releaseStatement(stmt);
+        if (!ok)
+            return false;
+    }
+
+    return true;
+}
+
+static bool saveNanos(int playerID, const SavedRows& old, const SavedRows& rows) {
+    const char* delNano = R"(
+        DELETE FROM Nanos WHERE PlayerID = ? AND ID = ?;
+        )";
+    const char* putNano = R"(
+        INSERT INTO Nanos (PlayerID, ID, SKill, Stamina)
+        VALUES (?, ?, ?, ?)
+        ON CONFLICT (PlayerID, ID) DO UPDATE SET
+            Skill = excluded.Skill, Stamina = excluded.Stamina;
+        )";
+
+    // rows are keyed by nano ID rather than by slot, so do all the deletions first,
+    // in case a nano shows up in a different slot than before
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < NANO_COUNT; i++) {
+            const sNano& nano = rows.nanos[i];
+            if (sameNano(old.nanos[i], nano))
+                continue;
+
+            sqlite3_stmt* stmt;
+            if (pass == 0) {
+                if (old.nanos[i].iID == 0 || old.nanos[i].iID == nano.iID)
+                    continue;
+
+                stmt = getStatement(delNano);
+                sqlite3_bind_int(stmt, 1, playerID);
+                sqlite3_bind_int(stmt, 2, old.nanos[i].iID);
+            } else {
+                if (nano.iID == 0)
+                    continue;
+
+                stmt = getStatement(putNano);
+                sqlite3_bind_int(stmt, 1, playerID);
+                sqlite3_bind_int(stmt, 2, nano.iID);
+                sqlite3_bind_int(stmt, 3, nano.iSkillID);
+                sqlite3_bind_int(stmt, 4, nano.iStamina);
+            }
+
+            bool ok = stepDone(stmt);
+            releaseStatement(stmt);
+            if (!ok)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+// there's only a handful of these and they aren't keyed by slot, so they're rewritten together
+static bool saveQuests(int playerID, bool known, const SavedRows& old, const SavedRows& rows) {
+    if (known && memcmp(old.tasks, rows.tasks, sizeof(rows.tasks)) == 0
+        && memcmp(old.remaining, rows.remaining, sizeof(rows.remaining)) == 0)
+        return true;
+
+    sqlite3_stmt* stmt;
+    if (known) {
+        stmt = getStatement("DELETE FROM RunningQuests WHERE PlayerID = ?;");
+        sqlite3_bind_int(stmt, 1, playerID);
+        bool ok = stepDone(stmt);
+        releaseStatement(stmt);
+        if (!ok)
+            return false;
+    }
+
+    const char* sql = R"(
+        INSERT INTO RunningQuests
+            (PlayerID, TaskID, RemainingNPCCount1, RemainingNPCCount2, RemainingNPCCount3)
+        VALUES (?, ?, ?, ?, ?);
+        )";
+    stmt = getStatement(sql);
+
+    for (int i = 0; i < ACTIVE_MISSION_COUNT; i++) {
+        if (rows.tasks[i] == 0)
+            continue;
+
+        sqlite3_bind_int(stmt, 1, playerID);
+        sqlite3_bind_int(stmt, 2, rows.tasks[i]);
+        sqlite3_bind_int(stmt, 3, rows.remaining[i][0]);
+        sqlite3_bind_int(stmt, 4, rows.remaining[i][1]);
+        sqlite3_bind_int(stmt, 5, rows.remaining[i][2]);
+
+        if (!stepDone(stmt)) {
+            releaseStatement(stmt);
+            return false;
+        }
+    }
+
+    releaseStatement(stmt);
+    return true;
+}
+
 static void removeExpiredVehicles(Player* player) {
     int32_t currentTime = getTimestamp();
 
@@ -37,8 +261,13 @@ static void removeExpiredVehicles(Player* player) {
 }
 
 void Database::getPlayer(Player* plr, int id) {
+    waitForPlayerSaves(); // in case they just left
     std::lock_guard<std::mutex> lock(dbCrit);
 
+    // what gets loaded isn't always exactly what's in the DB (e.g. expired vehicles),
+    // so have the next save write everything out again
+    forgetSavedRows(id);
+
     const char* sql = R"(
         SELECT
             p.AccountID, p.Slot, p.FirstName, p.LastName,
@@ -56,10 +285,10 @@ void Database::getPlayer(Player* plr, int id) {
         )";
     sqlite3_stmt* stmt;
 
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, id);
     if (sqlite3_step(stmt) != SQLITE_ROW) {
-        sqlite3_finalize(stmt);
+        releaseStatement(stmt);
         std::cout << "[WARN] Database: Failed to load character [" << id << "]: " << sqlite3_errmsg(db) << std::endl;
         return;
     }
@@ -118,7 +347,7 @@ void Database::getPlayer(Player* plr, int id) {
     plr->PCStyle.iHeight = sqlite3_column_int(stmt, 34);
     plr->PCStyle.iSkinColor = sqlite3_column_int(stmt, 35);
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
     // get inventory
     sql = R"(
@@ -127,7 +356,7 @@ void Database::getPlayer(Player* plr, int id) {
         WHERE PlayerID = ?;
         )";
 
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
 
     sqlite3_bind_int(stmt, 1, id);
 
@@ -158,7 +387,7 @@ void Database::getPlayer(Player* plr, int id) {
         item->iTimeLimit = sqlite3_column_int(stmt, 4);
     }
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
     removeExpiredVehicles(plr);
 
@@ -169,7 +398,7 @@ void Database::getPlayer(Player* plr, int id) {
         WHERE PlayerID = ?;
         )";
 
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
 
     sqlite3_bind_int(stmt, 1, id);
 
@@ -186,7 +415,7 @@ void Database::getPlayer(Player* plr, int id) {
         item->iOpt = sqlite3_column_int(stmt, 2);
     }
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
     // get nanos
     sql = R"(
@@ -195,7 +424,7 @@ void Database::getPlayer(Player* plr, int id) {
         WHERE PlayerID = ?;
         )";
 
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, id);
 
     while (sqlite3_step(stmt) == SQLITE_ROW) {
@@ -211,7 +440,7 @@ void Database::getPlayer(Player* plr, int id) {
         nano->iStamina = sqlite3_column_int(stmt, 2);
     }
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
     // get active quests
     sql = R"(
@@ -224,7 +453,7 @@ void Database::getPlayer(Player* plr, int id) {
         WHERE PlayerID = ?;
         )";
 
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, id);
 
     std::set<int> tasksSet; // used to prevent duplicate tasks from loading in
@@ -241,7 +470,7 @@ void Database::getPlayer(Player* plr, int id) {
         plr->RemainingNPCCount[i][2] = sqlite3_column_int(stmt, 3);
     }
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
     // get buddies
     sql = R"(
@@ -250,7 +479,7 @@ void Database::getPlayer(Player* plr, int id) {
         WHERE PlayerAID = ? OR PlayerBID = ?;
         )";
 
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, id);
     sqlite3_bind_int(stmt, 2, id);
 
@@ -264,7 +493,7 @@ void Database::getPlayer(Player* plr, int id) {
         i++;
     }
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
     // get blocked players
     sql = R"(
@@ -272,7 +501,7 @@ void Database::getPlayer(Player* plr, int id) {
         WHERE PlayerID = ?;
         )";
 
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, id);
 
     // i retains its value from after the loop over Buddyships
@@ -282,7 +511,7 @@ void Database::getPlayer(Player* plr, int id) {
         i++;
     }
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 }
 
 /*
@@ -304,7 +533,7 @@ bool Database::_updatePlayer(Player *player) {
         WHERE PlayerID = ?;
         )";
     sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, player->level);
     sqlite3_bind_int(stmt, 2, player->equippedNanos[0]);
     sqlite3_bind_int(stmt, 3, player->equippedNanos[1]);
@@ -338,223 +567,37 @@ bool Database::_updatePlayer(Player *player) {
     sqlite3_bind_int(stmt, 21, player->iID);
 
     if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
+        releaseStatement(stmt);
         return false;
     }
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
-    // update inventory
-    sql = R"(
-        DELETE FROM Inventory WHERE PlayerID = ?;
-        )";
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-    sqlite3_bind_int(stmt, 1, player->iID);
-    int rc = sqlite3_step(stmt);
-
-    sqlite3_finalize(stmt);
-
-    sql = R"(
-        INSERT INTO Inventory
-            (PlayerID, Slot, Type, Opt, ID, Timelimit)
-        VALUES (?, ?, ?, ?, ?, ?);
-        )";
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-
-    for (int i = 0; i < AEQUIP_COUNT; i++) {
-        if (player->Equip[i].iID == 0)
-            continue;
-
-        sqlite3_bind_int(stmt, 1, player->iID);
-        sqlite3_bind_int(stmt, 2, i);
-        sqlite3_bind_int(stmt, 3, player->Equip[i].iType);
-        sqlite3_bind_int(stmt, 4, player->Equip[i].iOpt);
-        sqlite3_bind_int(stmt, 5, player->Equip[i].iID);
-        sqlite3_bind_int(stmt, 6, player->Equip[i].iTimeLimit);
-
-        rc = sqlite3_step(stmt);
-
-        if (rc != SQLITE_DONE) {
-            sqlite3_finalize(stmt);
-            return false;
-        }
-        sqlite3_reset(stmt);
-    }
-
-    for (int i = 0; i < AINVEN_COUNT; i++) {
-        if (player->Inven[i].iID == 0)
-            continue;
-
-        sqlite3_bind_int(stmt, 1, player->iID);
-        sqlite3_bind_int(stmt, 2, i + AEQUIP_COUNT);
-        sqlite3_bind_int(stmt, 3, player->Inven[i].iType);
-        sqlite3_bind_int(stmt, 4, player->Inven[i].iOpt);
-        sqlite3_bind_int(stmt, 5, player->Inven[i].iID);
-        sqlite3_bind_int(stmt, 6, player->Inven[i].iTimeLimit);
-
-        if (sqlite3_step(stmt) != SQLITE_DONE) {
-            sqlite3_finalize(stmt);
-            return false;
-        }
-        sqlite3_reset(stmt);
-    }
-
-    for (int i = 0; i < ABANK_COUNT; i++) {
-        if (player->Bank[i].iID == 0)
-            continue;
-
-        sqlite3_bind_int(stmt, 1, player->iID);
-        sqlite3_bind_int(stmt, 2, i + AEQUIP_COUNT + AINVEN_COUNT);
-        sqlite3_bind_int(stmt, 3, player->Bank[i].iType);
-        sqlite3_bind_int(stmt, 4, player->Bank[i].iOpt);
-        sqlite3_bind_int(stmt, 5, player->Bank[i].iID);
-        sqlite3_bind_int(stmt, 6, player->Bank[i].iTimeLimit);
-
-        if (sqlite3_step(stmt) != SQLITE_DONE) {
-            sqlite3_finalize(stmt);
-            return false;
-        }
-        sqlite3_reset(stmt);
-    }
-
-    sqlite3_finalize(stmt);
-
-    // Update Quest Inventory
-    sql = R"(
-        DELETE FROM QuestItems WHERE PlayerID = ?;
-        )";
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-    sqlite3_bind_int(stmt, 1, player->iID);
-    sqlite3_step(stmt);
-
-    sqlite3_finalize(stmt);
-
-    sql = R"(
-        INSERT INTO QuestItems (PlayerID, Slot, Opt, ID)
-        VALUES (?, ?, ?, ?);
-        )";
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-
-    for (int i = 0; i < AQINVEN_COUNT; i++) {
-        if (player->QInven[i].iID == 0)
-            continue;
-
-        sqlite3_bind_int(stmt, 1, player->iID);
-        sqlite3_bind_int(stmt, 2, i);
-        sqlite3_bind_int(stmt, 3, player->QInven[i].iOpt);
-        sqlite3_bind_int(stmt, 4, player->QInven[i].iID);
-
-        if (sqlite3_step(stmt) != SQLITE_DONE) {
-            sqlite3_finalize(stmt);
-            return false;
-        }
-        sqlite3_reset(stmt);
-    }
-
-    sqlite3_finalize(stmt);
-
-    // Update Nanos
-    sql = R"(
-        DELETE FROM Nanos WHERE PlayerID = ?;
-        )";
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-    sqlite3_bind_int(stmt, 1, player->iID);
-    sqlite3_step(stmt);
-
-    sqlite3_finalize(stmt);
-
-    sql = R"(
-        INSERT INTO Nanos (PlayerID, ID, SKill, Stamina)
-        VALUES (?, ?, ?, ?);
-        )";
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-
-    for (int i = 0; i < NANO_COUNT; i++) {
-        if (player->Nanos[i].iID == 0)
-            continue;
-
-        sqlite3_bind_int(stmt, 1, player->iID);
-        sqlite3_bind_int(stmt, 2, player->Nanos[i].iID);
-        sqlite3_bind_int(stmt, 3, player->Nanos[i].iSkillID);
-        sqlite3_bind_int(stmt, 4, player->Nanos[i].iStamina);
-
-        if (sqlite3_step(stmt) != SQLITE_DONE) {
-            sqlite3_finalize(stmt);
-            return false;
-        }
-        sqlite3_reset(stmt);
-    }
-
-    sqlite3_finalize(stmt);
-
-    // Update Running Quests
-    sql = R"(
-        DELETE FROM RunningQuests WHERE PlayerID = ?;
-        )";
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-    sqlite3_bind_int(stmt, 1, player->iID);
-    sqlite3_step(stmt);
-
-    sqlite3_finalize(stmt);
-
-    sql = R"(
-        INSERT INTO RunningQuests
-            (PlayerID, TaskID, RemainingNPCCount1, RemainingNPCCount2, RemainingNPCCount3)
-        VALUES (?, ?, ?, ?, ?);
-        )";
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    // the first save since they were loaded rewrites everything
+    auto it = savedRows.find(player->iID);
+    bool known = it != savedRows.end();
+    if (!known && !clearRows(player->iID))
+        return false;
 
-    for (int i = 0; i < ACTIVE_MISSION_COUNT; i++) {
-        if (player->tasks[i] == 0)
-            continue;
-        sqlite3_bind_int(stmt, 1, player->iID);
-        sqlite3_bind_int(stmt, 2, player->tasks[i]);
-        sqlite3_bind_int(stmt, 3, player->RemainingNPCCount[i][0]);
-        sqlite3_bind_int(stmt, 4, player->RemainingNPCCount[i][1]);
-        sqlite3_bind_int(stmt, 5, player->RemainingNPCCount[i][2]);
-
-        if (sqlite3_step(stmt) != SQLITE_DONE) {
-            sqlite3_finalize(stmt);
-            return false;
-        }
-        sqlite3_reset(stmt);
+    static const SavedRows emptyRows = {};
+    const SavedRows& old = known ? it->second : emptyRows;
+
+    // what the DB will hold once this save is through
+    SavedRows rows;
+    memcpy(rows.items, player->Equip, sizeof(player->Equip));
+    memcpy(rows.items + AEQUIP_COUNT, player->Inven, sizeof(player->Inven));
+    memcpy(rows.items + AEQUIP_COUNT + AINVEN_COUNT, player->Bank, sizeof(player->Bank));
+    memcpy(rows.qitems, player->QInven, sizeof(player->QInven));
+    memcpy(rows.nanos, player->Nanos, sizeof(player->Nanos));
+    memcpy(rows.tasks, player->tasks, sizeof(player->tasks));
+    memcpy(rows.remaining, player->RemainingNPCCount, sizeof(player->RemainingNPCCount));
+
+    if (!saveItems(player->iID, old, rows) || !saveNanos(player->iID, old, rows)
+        || !saveQuests(player->iID, known, old, rows)) {
+        savedRows.erase(player->iID); // we no longer know what the DB holds
+        return false;
     }
 
-    sqlite3_finalize(stmt);
-
+    savedRows[player->iID] = rows;
     return true;
 }
-
-void Database::updatePlayer(Player *player) {
-    std::lock_guard<std::mutex> lock(dbCrit);
-
-    sqlite3_exec(db, "BEGIN TRANSACTION;", NULL, NULL, NULL);
-
-    if (!_updatePlayer(player)) {
-        std::cout << "[WARN] Database: Failed to save player to database: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_exec(db, "ROLLBACK TRANSACTION;", NULL, NULL, NULL);
-        return;
-    }
-
-    sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
-}
-
-void Database::commitTrade(Player *plr1, Player *plr2) {
-    std::lock_guard<std::mutex> lock(dbCrit);
-
-    sqlite3_exec(db, "BEGIN TRANSACTION;", NULL, NULL, NULL);
-
-    if (!_updatePlayer(plr1)) {
-        std::cout << "[WARN] Database: Failed to save player to database: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_exec(db, "ROLLBACK TRANSACTION;", NULL, NULL, NULL);
-        return;
-    }
-
-    if (!_updatePlayer(plr2)) {
-        std::cout << "[WARN] Database: Failed to save player to database: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_exec(db, "ROLLBACK TRANSACTION;", NULL, NULL, NULL);
-        return;
-    }
-
-    sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
-}
@@ -14,12 +14,12 @@ static int getAccountIDFromPlayerID(int playerId, int *accountLevel=nullptr) {
     sqlite3_stmt *stmt;
 
     // get AccountID from PlayerID
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, playerId);
 
     if (sqlite3_step(stmt) != SQLITE_ROW) {
         std::cout << "[WARN] Database: failed to get AccountID from PlayerID: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_finalize(stmt);
+        releaseStatement(stmt);
         return -1;
     }
 
@@ -29,7 +29,7 @@ static int getAccountIDFromPlayerID(int playerId, int *accountLevel=nullptr) {
     if (accountLevel != nullptr)
         *accountLevel = sqlite3_column_int(stmt, 1);
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
     return accountId;
 }
@@ -44,7 +44,7 @@ static bool banAccount(int accountId, int days, std::string& reason) {
         )";
     sqlite3_stmt* stmt;
 
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
 
     sqlite3_bind_int(stmt, 1, days * 86400); // convert days to seconds
     sqlite3_bind_text(stmt, 2, reason.c_str(), -1, NULL);
@@ -52,11 +52,11 @@ static bool banAccount(int accountId, int days, std::string& reason) {
 
     if (sqlite3_step(stmt) != SQLITE_DONE) {
         std::cout << "[WARN] Database: failed to ban account: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_finalize(stmt);
+        releaseStatement(stmt);
         return false;
     }
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
     return true;
 }
 
@@ -70,17 +70,17 @@ static bool unbanAccount(int accountId) {
         )";
     sqlite3_stmt* stmt;
 
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
 
     sqlite3_bind_int(stmt, 1, accountId);
 
     if (sqlite3_step(stmt) != SQLITE_DONE) {
         std::cout << "[WARN] Database: failed to unban account: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_finalize(stmt);
+        releaseStatement(stmt);
         return false;
     }
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
     return true;
 }
 
@@ -130,25 +130,25 @@ int Database::getNumBuddies(Player* player) {
         WHERE PlayerAID = ? OR PlayerBID = ?;
         )";
     sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, player->iID);
     sqlite3_bind_int(stmt, 2, player->iID);
     sqlite3_step(stmt);
     int result = sqlite3_column_int(stmt, 0);
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
     sql = R"(
         SELECT COUNT(*)
         FROM Blocks
         WHERE PlayerID = ?;
         )";
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, player->iID);
     sqlite3_step(stmt);
     result += sqlite3_column_int(stmt, 0);
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 
     // again, for peace of mind
     return result > 50 ? 50 : result;
@@ -162,13 +162,13 @@ void Database::addBuddyship(int playerA, int playerB) {
         VALUES (?, ?);
         )";
     sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, playerA);
     sqlite3_bind_int(stmt, 2, playerB);
 
     if (sqlite3_step(stmt) != SQLITE_DONE)
         std::cout << "[WARN] Database: failed to add buddyship: " << sqlite3_errmsg(db) << std::endl;
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 }
 
 void Database::removeBuddyship(int playerA, int playerB) {
@@ -179,14 +179,14 @@ void Database::removeBuddyship(int playerA, int playerB) {
         WHERE (PlayerAID = ? AND PlayerBID = ?) OR (PlayerAID = ? AND PlayerBID = ?);
         )";
     sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, playerA);
     sqlite3_bind_int(stmt, 2, playerB);
     sqlite3_bind_int(stmt, 3, playerB);
     sqlite3_bind_int(stmt, 4, playerA);
 
     sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 }
 
 // blocking
@@ -198,13 +198,13 @@ void Database::addBlock(int playerId, int blockedPlayerId) {
         VALUES (?, ?);
         )";
     sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, playerId);
     sqlite3_bind_int(stmt, 2, blockedPlayerId);
 
     if (sqlite3_step(stmt) != SQLITE_DONE)
         std::cout << "[WARN] Database: failed to block player: " << sqlite3_errmsg(db) << std::endl;
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 }
 
 void Database::removeBlock(int playerId, int blockedPlayerId) {
@@ -215,34 +215,36 @@ void Database::removeBlock(int playerId, int blockedPlayerId) {
         WHERE PlayerID = ? AND BlockedPlayerID = ?;
         )";
     sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, playerId);
     sqlite3_bind_int(stmt, 2, blockedPlayerId);
 
     sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 }
 
 RaceRanking Database::getTopRaceRanking(int epID, int playerID) {
     std::lock_guard<std::mutex> lock(dbCrit);
-    std::string sql(R"(
+    const char* sql = R"(
         SELECT
             EPID, PlayerID, Score, RingCount, Time, Timestamp
         FROM RaceResults
         WHERE EPID = ?
-        )");
-
-    if (playerID > -1)
-        sql += " AND PlayerID = ? ";
-
-    sql += R"(
         ORDER BY Score DESC
         LIMIT 1;
         )";
 
-    sqlite3_stmt* stmt;
-
-    sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, NULL);
+    if (playerID > -1)
+        sql = R"(
+            SELECT
+                EPID, PlayerID, Score, RingCount, Time, Timestamp
+            FROM RaceResults
+            WHERE EPID = ? AND PlayerID = ?
+            ORDER BY Score DESC
+            LIMIT 1;
+            )";
+
+    sqlite3_stmt* stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, epID);
     if(playerID > -1)
         sqlite3_bind_int(stmt, 2, playerID);
@@ -250,7 +252,7 @@ RaceRanking Database::getTopRaceRanking(int epID, int playerID) {
     RaceRanking ranking = {};
     if (sqlite3_step(stmt) != SQLITE_ROW) {
         // this race hasn't been run before, so return a blank ranking
-        sqlite3_finalize(stmt);
+        releaseStatement(stmt);
         return ranking;
     }
 
@@ -263,7 +265,7 @@ RaceRanking Database::getTopRaceRanking(int epID, int playerID) {
     ranking.Time = sqlite3_column_int64(stmt, 4);
     ranking.Timestamp = sqlite3_column_int64(stmt, 5);
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
     return ranking;
 }
 
@@ -277,7 +279,7 @@ void Database::postRaceRanking(RaceRanking ranking) {
         )";
     sqlite3_stmt* stmt;
 
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, ranking.EPID);
     sqlite3_bind_int(stmt, 2, ranking.PlayerID);
     sqlite3_bind_int(stmt, 3, ranking.Score);
@@ -289,7 +291,7 @@ void Database::postRaceRanking(RaceRanking ranking) {
         std::cout << "[WARN] Database: Failed to post race result" << std::endl;
     }
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 }
 
 bool Database::isCodeRedeemed(int playerId, std::string code) {
@@ -303,13 +305,13 @@ bool Database::isCodeRedeemed(int playerId, std::string code) {
         )";
     sqlite3_stmt* stmt;
 
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, playerId);
     sqlite3_bind_text(stmt, 2, code.c_str(), -1, NULL);
     sqlite3_step(stmt);
     int result = sqlite3_column_int(stmt, 0);
 
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
     return result;
 }
 
@@ -321,11 +323,11 @@ void Database::recordCodeRedemption(int playerId, std::string code) {
         VALUES (?, ?);
         )";
     sqlite3_stmt* stmt;
-    sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    stmt = getStatement(sql);
     sqlite3_bind_int(stmt, 1, playerId);
     sqlite3_bind_text(stmt, 2, code.c_str(), -1, NULL);
     
     if (sqlite3_step(stmt) != SQLITE_DONE)
         std::cout << "[WARN] Database: recording of code redemption failed: " << sqlite3_errmsg(db) << std::endl;
-    sqlite3_finalize(stmt);
+    releaseStatement(stmt);
 }
@@ -0,0 +1,174 @@
+#include "db/internal.hpp"
+
+#include <thread>
+#include <condition_variable>
+#include <deque>
+
+/*
+ * Player saves are written out by a thread of their own, so the shard never
+ * has to wait on the disk. The shard thread queues copies of its players,
+ * taken at the time of the save, and the writer saves each batch of them in
+ * a single transaction.
+ */
+
+struct SaveBatch {
+    std::vector<Player*> players; // copies, owned by the batch
+    bool atomic = false; // all or nothing, instead of each player on their own
+};
+
+// never destroyed, since the writer is still waiting on these if something exits without closing the DB
+static std::mutex& queueLock = *new std::mutex();
+static std::condition_variable& queueCv = *new std::condition_variable(); // more work, or time to stop
+static std::condition_variable& drainedCv = *new std::condition_variable(); // nothing left to write
+static std::deque<SaveBatch> batches;
+static SaveBatch collecting; // what flushPlayerSaves() will hand over next
+static bool writing = false;
+static bool stopping = false;
+static std::thread *writer = nullptr;
+
+// none of the batch made it to the DB after all
+static void forgetBatch(SaveBatch& batch) {
+    for (Player *plr : batch.players)
+        forgetSavedRows(plr->iID);
+}
+
+static void writeBatch(SaveBatch& batch) {
+    std::lock_guard<std::mutex> lock(dbCrit);
+
+    sqlite3_exec(db, "BEGIN TRANSACTION;", NULL, NULL, NULL);
+
+    for (Player *plr : batch.players) {
+        if (!batch.atomic)
+            sqlite3_exec(db, "SAVEPOINT player;", NULL, NULL, NULL);
+
+        if (_updatePlayer(plr)) {
+            if (!batch.atomic)
+                sqlite3_exec(db, "RELEASE player;", NULL, NULL, NULL);
+            continue;
+        }
+
+        std::cout << "[WARN] Database: Failed to save player to database: " << sqlite3_errmsg(db) << std::endl;
+
+        if (batch.atomic) {
+            sqlite3_exec(db, "ROLLBACK TRANSACTION;", NULL, NULL, NULL);
+            forgetBatch(batch);
+            return;
+        }
+
+        // only lose this one
+        sqlite3_exec(db, "ROLLBACK TO player;", NULL, NULL, NULL);
+        sqlite3_exec(db, "RELEASE player;", NULL, NULL, NULL);
+    }
+
+    if (sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK) {
+        std::cout << "[WARN] Database: Failed to commit player saves: " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_exec(db, "ROLLBACK TRANSACTION;", NULL, NULL, NULL);
+        forgetBatch(batch);
+    }
+}
+
+static void freeBatch(SaveBatch& batch) {
+    for (Player *plr : batch.players)
+        delete plr;
+    batch.players.clear();
+}
+
+static void writerLoop() {
+    std::unique_lock<std::mutex> lock(queueLock);
+
+    while (true) {
+        queueCv.wait(lock, [] { return !batches.empty() || stopping; });
+        if (batches.empty())
+            return; // stopping, and everything has been written
+
+        SaveBatch batch = std::move(batches.front());
+        batches.pop_front();
+        writing = true;
+
+        lock.unlock();
+        writeBatch(batch);
+        freeBatch(batch);
+        lock.lock();
+
+        writing = false;
+        if (batches.empty())
+            drainedCv.notify_all();
+    }
+}
+
+static void enqueue(SaveBatch&& batch) {
+    if (batch.players.empty())
+        return;
+
+    // without a writer, just save on the spot
+    if (writer == nullptr) {
+        writeBatch(batch);
+        freeBatch(batch);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queueLock);
+        batches.push_back(std::move(batch));
+    }
+    queueCv.notify_one();
+}
+
+void Database::startWriter() {
+    if (writer != nullptr)
+        return;
+
+    stopping = false;
+    writer = new std::thread(writerLoop);
+}
+
+// writes out whatever is still queued first
+void Database::stopWriter() {
+    if (writer == nullptr)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(queueLock);
+        stopping = true;
+    }
+    queueCv.notify_one();
+
+    writer->join();
+    delete writer;
+    writer = nullptr;
+}
+
+void Database::queuePlayerSave(Player *player) {
+    std::lock_guard<std::mutex> lock(queueLock);
+    collecting.players.push_back(new Player(*player));
+}
+
+void Database::flushPlayerSaves() {
+    SaveBatch batch;
+    {
+        std::lock_guard<std::mutex> lock(queueLock);
+        std::swap(batch, collecting);
+    }
+
+    enqueue(std::move(batch));
+}
+
+void Database::waitForPlayerSaves() {
+    std::unique_lock<std::mutex> lock(queueLock);
+    drainedCv.wait(lock, [] { return batches.empty() && !writing; });
+}
+
+void Database::updatePlayer(Player *player) {
+    queuePlayerSave(player);
+    flushPlayerSaves();
+}
+
+// both players are saved together or not at all
+void Database::commitTrade(Player *plr1, Player *plr2) {
+    SaveBatch batch;
+    batch.atomic = true;
+    batch.players.push_back(new Player(*plr1));
+    batch.players.push_back(new Player(*plr2));
+
+    enqueue(std::move(batch));
+}
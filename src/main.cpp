@@ -112,7 +112,9 @@ int main() {
     initsignals();
     settings::init();
     Database::init();
-    Rand::init(getTime());
+    uint64_t seed = settings::RANDSEED != 0 ? settings::RANDSEED : getTime();
+    Rand::init(seed);
+    std::cout << "[INFO] Random seed: " << seed << std::endl;
     TableData::init();
 
     std::cout << "[INFO] Intializing Packet Managers..." << std::endl;
@@ -32,6 +32,7 @@ void sandbox_start() {
     eunveil(settings::DBPATH.c_str(), "rwc");
     eunveil((settings::DBPATH + "-journal").c_str(), "rwc");
     eunveil((settings::DBPATH + "-wal").c_str(), "rwc");
+    eunveil((settings::DBPATH + "-shm").c_str(), "rwc");
 
     // tabledata stuff
     eunveil((settings::TDATADIR + "/" + settings::GRUNTWORKJSON).c_str(), "wc");
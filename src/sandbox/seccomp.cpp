@@ -141,6 +141,7 @@ static sock_filter filter[] = {
     ALLOW_SYSCALL_ARG_MASK(mmap, 2, PROT_NONE|PROT_READ|PROT_WRITE),
 #endif
     ALLOW_SYSCALL(munmap),
+    ALLOW_SYSCALL(mremap), // growing the memory-mapped DB
     ALLOW_SYSCALL_ARG_MASK(mprotect, 2, PROT_NONE|PROT_READ|PROT_WRITE),
     ALLOW_SYSCALL(madvise),
     ALLOW_SYSCALL(brk),
@@ -214,6 +215,11 @@ static sock_filter filter[] = {
 #ifdef __NR_accept
     ALLOW_SYSCALL(accept),
 #endif
+#ifdef __NR_epoll_wait
+    ALLOW_SYSCALL(epoll_wait),
+#endif
+    ALLOW_SYSCALL(epoll_pwait), // glibc on AArch64
+    ALLOW_SYSCALL(epoll_ctl),
     ALLOW_SYSCALL(setsockopt),
     ALLOW_SYSCALL(sendto),
     ALLOW_SYSCALL(recvfrom),
@@ -8,15 +8,113 @@
 #include "Items.hpp"
 #include "settings.hpp"
 
-#include <regex>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <unordered_map>
 
 std::map<CNSocket*, CNLoginData> CNLoginServer::loginSessions;
 
+#pragma region passwordWorkers
+
+/*
+ * bcrypt is slow on purpose, so passwords are checked and hashed by a few
+ * threads of their own, instead of holding up every other socket on the login
+ * server. The threads are started along with the login server, before the
+ * sandbox is engaged, and finished jobs are picked up again in onStep().
+ */
+struct PasswordJob {
+    uint64_t id;
+    CNSocket* sock;
+    uint32_t ip;
+    sP_CL2LS_REQ_LOGIN request;
+    std::string userLogin;
+    std::string userPassword;
+    Database::Account account; // the account being logged into, unless it's a new one
+    bool newAccount; // hash the password for a new account, instead of checking it
+
+    // results
+    bool passwordCorrect;
+    std::string passwordHash;
+};
+
+static void runPasswordJob(PasswordJob& job) {
+    if (job.newAccount)
+        job.passwordHash = BCrypt::generateHash(job.userPassword);
+    else
+        job.passwordCorrect = BCrypt::validatePassword(job.userPassword, job.account.Password);
+}
+
+class PasswordWorkers {
+private:
+    std::mutex mtx;
+    std::condition_variable wake;
+    std::deque<PasswordJob> queued;
+    std::vector<PasswordJob> finished;
+
+    void work() {
+        std::unique_lock<std::mutex> lock(mtx);
+
+        while (true) {
+            wake.wait(lock, [&] { return !queued.empty(); });
+            PasswordJob job = std::move(queued.front());
+            queued.pop_front();
+
+            lock.unlock();
+            runPasswordJob(job);
+            lock.lock();
+
+            finished.push_back(std::move(job));
+        }
+    }
+
+public:
+    PasswordWorkers(int n) {
+        for (int i = 0; i < n; i++)
+            std::thread(&PasswordWorkers::work, this).detach();
+    }
+
+    void submit(PasswordJob&& job) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            queued.push_back(std::move(job));
+        }
+        wake.notify_one();
+    }
+
+    // hands over every job that's been finished since the last call
+    void collect(std::vector<PasswordJob>& out) {
+        std::lock_guard<std::mutex> lock(mtx);
+        std::swap(out, finished);
+    }
+};
+
+// never freed, like the AI workers
+static PasswordWorkers *passwordWorkers = nullptr;
+
+// the rest is only touched by the login server's thread
+static std::unordered_map<CNSocket*, uint64_t> pendingLogins; // socket -> ID of the job it's waiting on
+static std::unordered_map<uint32_t, int> jobsPerIP;
+static int pendingJobs = 0;
+static uint64_t nextJobID = 1;
+
+// past these, logins are turned away instead of waiting in line for seconds on end
+#define MAX_PASSWORD_JOBS_PER_THREAD 16
+#define MAX_PASSWORD_JOBS_PER_IP 4
+
+#pragma endregion
+
 CNLoginServer::CNLoginServer(uint16_t p) {
     serverType = "login";
     port = p;
     pHandler = &CNLoginServer::handlePacket;
     init();
+
+    if (settings::PASSWORDTHREADS > 0 && passwordWorkers == nullptr) {
+        passwordWorkers = new PasswordWorkers(settings::PASSWORDTHREADS);
+        std::cout << "[INFO] Checking passwords on " << settings::PASSWORDTHREADS << " extra thread(s)" << std::endl;
+    }
 }
 
 void CNLoginServer::handlePacket(CNSocket* sock, CNPacketData* data) {
@@ -127,7 +225,7 @@ void CNLoginServer::login(CNSocket* sock, CNPacketData* data) {
     if (int(userPassword.find("\n")) > 0)
         userPassword.erase(userPassword.find("\n"), 1);
 
-    // check regex
+    // check the login and password rules
     if (!CNLoginServer::isLoginDataGood(userLogin, userPassword)) {
         // send a custom error message
         INITSTRUCT(sP_FE2CL_GM_REP_PC_ANNOUNCE, msg);
@@ -143,20 +241,74 @@ void CNLoginServer::login(CNSocket* sock, CNPacketData* data) {
     }
         
 
-    Database::Account findUser = {};
-    Database::findAccount(&findUser, userLogin);
+    // still waiting on the password from their last attempt
+    if (pendingLogins.find(sock) != pendingLogins.end())
+        return;
+
+    PasswordJob job = {};
+    job.sock = sock;
+    job.ip = sock->sockaddr.sin_addr.s_addr;
+    job.request = *login;
+    job.userLogin = userLogin;
+    job.userPassword = userPassword;
+
+    Database::findAccount(&job.account, userLogin);
     
     // account was not found
-    if (findUser.AccountID == 0) {
-        if (settings::AUTOCREATEACCOUNTS)
-            return newAccount(sock, userLogin, userPassword, login->iClientVerC);
+    if (job.account.AccountID == 0) {
+        if (!settings::AUTOCREATEACCOUNTS)
+            return loginFail(LoginError::ID_DOESNT_EXIST, userLogin, sock);
+
+        job.newAccount = true;
+    }
+
+    if (passwordWorkers == nullptr) {
+        runPasswordJob(job);
+        return passwordChecked(job);
+    }
+
+    auto ipJobs = jobsPerIP.find(job.ip);
+    if (pendingJobs >= settings::PASSWORDTHREADS * MAX_PASSWORD_JOBS_PER_THREAD || (ipJobs != jobsPerIP.end() && ipJobs->second >= MAX_PASSWORD_JOBS_PER_IP)) {
+        INITSTRUCT(sP_FE2CL_GM_REP_PC_ANNOUNCE, msg);
+        U8toU16("The server is busy, please try again in a moment", msg.szAnnounceMsg, sizeof(msg.szAnnounceMsg));
+        msg.iDuringTime = 15;
+        sock->sendPacket(msg, P_FE2CL_GM_REP_PC_ANNOUNCE);
+
+        return loginFail(LoginError::LOGIN_ERROR, userLogin, sock);
+    }
+
+    job.id = nextJobID++;
+    pendingLogins[sock] = job.id;
+    jobsPerIP[job.ip]++;
+    pendingJobs++;
+
+    passwordWorkers->submit(std::move(job));
+}
 
-        return loginFail(LoginError::ID_DOESNT_EXIST, userLogin, sock);
+// picks the login back up once bcrypt is done with the password
+void CNLoginServer::passwordChecked(PasswordJob& job) {
+    if (passwordWorkers != nullptr) {
+        pendingJobs--;
+        if (--jobsPerIP[job.ip] == 0)
+            jobsPerIP.erase(job.ip);
+
+        // they may have disconnected in the meantime
+        auto it = pendingLogins.find(job.sock);
+        if (it == pendingLogins.end() || it->second != job.id)
+            return;
+        pendingLogins.erase(it);
     }
 
-    if (!CNLoginServer::isPasswordCorrect(findUser.Password, userPassword))
-        return loginFail(LoginError::ID_AND_PASSWORD_DO_NOT_MATCH, userLogin, sock);
+    if (job.newAccount)
+        return newAccount(job.sock, job.userLogin, job.passwordHash, job.request.iClientVerC);
 
+    if (!job.passwordCorrect)
+        return loginFail(LoginError::ID_AND_PASSWORD_DO_NOT_MATCH, job.userLogin, job.sock);
+
+    finishLogin(job.sock, &job.request, job.account, job.userLogin);
+}
+
+void CNLoginServer::finishLogin(CNSocket* sock, sP_CL2LS_REQ_LOGIN* login, Database::Account& findUser, std::string userLogin) {
     // is the account banned
     if (findUser.BannedUntil > getTimestamp()) {
         // send a custom error message
@@ -238,8 +390,8 @@ void CNLoginServer::login(CNSocket* sock, CNPacketData* data) {
     )
 }
 
-void CNLoginServer::newAccount(CNSocket* sock, std::string userLogin, std::string userPassword, int32_t clientVerC) {   
-    int userID = Database::addAccount(userLogin, userPassword);
+void CNLoginServer::newAccount(CNSocket* sock, std::string userLogin, std::string passwordHash, int32_t clientVerC) {   
+    int userID = Database::addAccount(userLogin, passwordHash);
     // if query somehow failed
     if (userID == 0)
         return loginFail(LoginError::DATABASE_ERROR, userLogin, sock);
@@ -573,9 +725,19 @@ void CNLoginServer::killConnection(CNSocket* cns) {
         std::cout << "Login Server: Account [" << loginSessions[cns].userID << "] disconnected from login server" << std::endl;
     )
     loginSessions.erase(cns);
+    pendingLogins.erase(cns);
 }
 
 void CNLoginServer::onStep() {
+    if (passwordWorkers != nullptr && pendingJobs > 0) {
+        static std::vector<PasswordJob> finished;
+        passwordWorkers->collect(finished);
+
+        for (PasswordJob& job : finished)
+            passwordChecked(job);
+        finished.clear();
+    }
+
     time_t currTime = getTime();
     static time_t lastCheck = 0;
 
@@ -594,6 +756,11 @@ void CNLoginServer::onStep() {
     }
 }
 
+// wake up often while passwords are being checked, so logins aren't left waiting on the timeout
+int CNLoginServer::waitTimeout() {
+    return pendingJobs > 0 ? 2 : 50;
+}
+
 #pragma endregion
 
 #pragma region helperMethods
@@ -621,21 +788,77 @@ bool CNLoginServer::exitDuplicate(int accountId) {
     return false;
 }
 
-bool CNLoginServer::isLoginDataGood(std::string login, std::string password) {
-    std::regex loginRegex("[a-zA-Z0-9_-]{4,32}");
-    std::regex passwordRegex("[a-zA-Z0-9!@#$%^&*()_+]{8,32}");
+/*
+ * Character classes for the login, password and name rules, looked up once
+ * per character; these run on every login and name check.
+ */
+enum : uint8_t {
+    CHAR_ALNUM = 1,
+    CHAR_LOGIN = 2, // [a-zA-Z0-9_-]
+    CHAR_PASSWORD = 4 // [a-zA-Z0-9!@#$%^&*()_+]
+};
+
+struct CharClasses {
+    uint8_t bits[256] = {};
+
+    constexpr CharClasses() {
+        for (int c = 0; c < 256; c++) {
+            if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9'))
+                bits[c] = CHAR_ALNUM | CHAR_LOGIN | CHAR_PASSWORD;
+        }
+
+        for (const char *c = "_-"; *c != '\0'; c++)
+            bits[(uint8_t)*c] |= CHAR_LOGIN;
+        for (const char *c = "!@#$%^&*()_+"; *c != '\0'; c++)
+            bits[(uint8_t)*c] |= CHAR_PASSWORD;
+    }
+};
+
+static constexpr CharClasses charClasses;
+
+static bool isAllOf(const std::string& str, uint8_t charClass, size_t minLength, size_t maxLength) {
+    if (str.size() < minLength || str.size() > maxLength)
+        return false;
+
+    for (char c : str) {
+        if ((charClasses.bits[(uint8_t)c] & charClass) == 0)
+            return false;
+    }
+
+    return true;
+}
 
-    return (std::regex_match(login, loginRegex) && std::regex_match(password, passwordRegex));
+bool CNLoginServer::isLoginDataGood(const std::string& login, const std::string& password) {
+    return isAllOf(login, CHAR_LOGIN, 4, 32) && isAllOf(password, CHAR_PASSWORD, 8, 32);
 }
 
-bool CNLoginServer::isPasswordCorrect(std::string actualPassword, std::string tryPassword) {
-    return BCrypt::validatePassword(tryPassword, actualPassword);
+/*
+ * Allow alphanumeric, dot and space characters in names. A name has to start
+ * with an alphanumeric character, and a dot or a space has to come right after
+ * one, except for a space after a dot (as in "Jr. Smith").
+ *
+ * This accepts the same names as the regex this used to be,
+ *   ((?! )(?!\.)[a-zA-Z0-9]*\.{0,1}(?!\.+ +)[a-zA-Z0-9]* {0,1}(?! +))*$
+ * including the empty name, without its exponential backtracking.
+ */
+static bool isNameGood(const std::string& name) {
+    char prev = '\0'; // the class of the previous character; '\0' at the start
+
+    for (char c : name) {
+        if (charClasses.bits[(uint8_t)c] & CHAR_ALNUM)
+            prev = 'a';
+        else if (c == '.' && prev == 'a')
+            prev = '.';
+        else if (c == ' ' && (prev == 'a' || prev == '.'))
+            prev = ' ';
+        else
+            return false;
+    }
+
+    return true;
 }
 
-bool CNLoginServer::isCharacterNameGood(std::string Firstname, std::string Lastname) {
-    //Allow alphanumeric and dot characters in names(disallows dot and space characters at the beginning of a name)
-    std::regex firstnamecheck(R"(((?! )(?!\.)[a-zA-Z0-9]*\.{0,1}(?!\.+ +)[a-zA-Z0-9]* {0,1}(?! +))*$)");
-    std::regex lastnamecheck(R"(((?! )(?!\.)[a-zA-Z0-9]*\.{0,1}(?!\.+ +)[a-zA-Z0-9]* {0,1}(?! +))*$)");
-    return (std::regex_match(Firstname, firstnamecheck) && std::regex_match(Lastname, lastnamecheck));
+bool CNLoginServer::isCharacterNameGood(const std::string& Firstname, const std::string& Lastname) {
+    return isNameGood(Firstname) && isNameGood(Lastname);
 }
 #pragma endregion
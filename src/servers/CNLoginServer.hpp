@@ -3,6 +3,7 @@
 #include "core/Core.hpp"
 
 #include "Player.hpp"
+#include "db/Database.hpp"
 
 #include <map>
 
@@ -11,6 +12,9 @@ struct CNLoginData {
     time_t lastHeartbeat;
 };
 
+// a password waiting to be checked or hashed; see CNLoginServer.cpp
+struct PasswordJob;
+
 enum class LoginError {
     DATABASE_ERROR = 0,
     ID_DOESNT_EXIST = 1,
@@ -30,6 +34,8 @@ private:
     static std::map<CNSocket*, CNLoginData> loginSessions;
 
     static void login(CNSocket* sock, CNPacketData* data);
+    static void passwordChecked(PasswordJob& job);
+    static void finishLogin(CNSocket* sock, sP_CL2LS_REQ_LOGIN* login, Database::Account& findUser, std::string userLogin);
     static void nameCheck(CNSocket* sock, CNPacketData* data);
     static void nameSave(CNSocket* sock, CNPacketData* data);
     static void characterCreate(CNSocket* sock, CNPacketData* data);
@@ -39,11 +45,10 @@ private:
     static void changeName(CNSocket* sock, CNPacketData* data);
     static void duplicateExit(CNSocket* sock, CNPacketData* data);
 
-    static bool isLoginDataGood(std::string login, std::string password);
-    static bool isPasswordCorrect(std::string actualPassword, std::string tryPassword);
+    static bool isLoginDataGood(const std::string& login, const std::string& password);
     static bool isAccountInUse(int accountId);
-    static bool isCharacterNameGood(std::string Firstname, std::string Lastname);
-    static void newAccount(CNSocket* sock, std::string userLogin, std::string userPassword, int32_t clientVerC);
+    static bool isCharacterNameGood(const std::string& Firstname, const std::string& Lastname);
+    static void newAccount(CNSocket* sock, std::string userLogin, std::string passwordHash, int32_t clientVerC);
     // returns true if success
     static bool exitDuplicate(int accountId);
 public:
@@ -52,4 +57,5 @@ public:
     void newConnection(CNSocket* cns);
     void killConnection(CNSocket* cns);
     void onStep();
+    int waitTimeout();
 };
@@ -14,8 +14,12 @@
 #include <sstream>
 #include <cstdlib>
 
-std::map<uint32_t, PacketHandler> CNShardServer::ShardPackets;
+std::array<PacketHandler, Packets::TABLE_SIZE> CNShardServer::ShardPackets = {};
 std::list<TimerEvent> CNShardServer::Timers;
+std::priority_queue<ScheduledTimer> CNShardServer::timerQueue;
+std::unordered_map<uint64_t, OneShotHandler> CNShardServer::oneShotTimers;
+uint64_t CNShardServer::nextTimerId = 1;
+size_t CNShardServer::scheduledTimers = 0;
 
 CNShardServer::CNShardServer(uint16_t p) {
     serverType = "shard";
@@ -26,14 +30,17 @@ CNShardServer::CNShardServer(uint16_t p) {
     init();
 
     if (settings::MONITORENABLED)
-        fds.push_back({Monitor::init(), POLLIN});
+        addPollFD(Monitor::init());
 }
 
 void CNShardServer::handlePacket(CNSocket* sock, CNPacketData* data) {
     printPacket(data);
 
+    int i = Packets::index(data->type);
+    PacketHandler handler = i >= 0 ? ShardPackets[i] : nullptr;
+
     // if it's a valid packet
-    if (ShardPackets.find(data->type) != ShardPackets.end()) {
+    if (handler != nullptr) {
 
         // reject gameplay packets if not yet fully connected
         if (PlayerManager::players.find(sock) == PlayerManager::players.end()
@@ -48,7 +55,7 @@ void CNShardServer::handlePacket(CNSocket* sock, CNPacketData* data) {
         }
 
         // run the appropriate packet handler
-        ShardPackets[data->type](sock, data);
+        handler(sock, data);
     } else if (settings::VERBOSITY > 0) {
         std::cerr << "OpenFusion: SHARD UNIMPLM ERR. PacketType: " << Packets::p2str(data->type) << " (" << data->type << ")" << std::endl;
     }
@@ -80,16 +87,18 @@ void CNShardServer::periodicSaveTimer(CNServer* serv, time_t currTime) {
 
     std::cout << "[INFO] Saving " << PlayerManager::players.size() << " players to DB..." << std::endl;
 
+    // written in the background, in one transaction
     for (auto& pair : PlayerManager::players) {
-        Database::updatePlayer(pair.second);
+        Database::queuePlayerSave(pair.second);
     }
+    Database::flushPlayerSaves();
 
     TableData::flush();
     std::cout << "[INFO] Done." << std::endl;
 }
 
-bool CNShardServer::checkExtraSockets(int i) {
-    return Monitor::acceptConnection(fds[i].fd, fds[i].revents);
+bool CNShardServer::checkExtraSockets(SOCKET fd, int revents) {
+    return Monitor::acceptConnection(fd, revents);
 }
 
 void CNShardServer::newConnection(CNSocket* cns) {
@@ -115,6 +124,39 @@ void CNShardServer::kill() {
     CNServer::kill();
 }
 
+uint64_t CNShardServer::scheduleOnce(time_t delay, OneShotHandler handler) {
+    uint64_t id = nextTimerId++;
+
+    oneShotTimers[id] = handler;
+    timerQueue.push({getTime() + delay, id, nullptr});
+
+    return id;
+}
+
+// the heap entry stays behind and is skipped once it comes up
+void CNShardServer::cancelTimer(uint64_t id) {
+    oneShotTimers.erase(id);
+}
+
+void CNShardServer::runTimer(TimerEvent& event, time_t scheduled, time_t currTime) {
+    time_t lateness = currTime - scheduled;
+
+    event.handlr(this, currTime);
+
+    time_t runtime = getTime() - currTime;
+
+    event.runs++;
+    event.totalLateness += lateness;
+    event.maxLateness = std::max(event.maxLateness, lateness);
+    event.maxRuntime = std::max(event.maxRuntime, runtime);
+
+    // a whole interval went by; something is hogging the shard thread
+    if (settings::VERBOSITY > 0 && event.delta > 0 && (lateness > event.delta || runtime > event.delta)) {
+        std::cout << "[WARN] Timer " << event.name << " is overrunning its " << event.delta
+            << "ms interval (" << lateness << "ms late, ran for " << runtime << "ms)" << std::endl;
+    }
+}
+
 void CNShardServer::onStep() {
     time_t currTime = getTime();
 
@@ -122,17 +164,48 @@ void CNShardServer::onStep() {
     if (!active)
         return;
 
-    for (TimerEvent& event : Timers) {
-        if (event.scheduledEvent == 0) {
-            // event hasn't been queued yet, go ahead and do that
+    // queue up any newly registered timers
+    if (scheduledTimers != Timers.size()) {
+        for (TimerEvent& event : Timers) {
+            if (event.scheduledEvent != 0)
+                continue;
+
             event.scheduledEvent = currTime + event.delta;
-            continue;
+            timerQueue.push({event.scheduledEvent, nextTimerId++, &event});
+            scheduledTimers++;
         }
+    }
 
-        if (event.scheduledEvent < currTime) {
-            // timer needs to be called
-            event.handlr(this, currTime);
-            event.scheduledEvent = currTime + event.delta;
+    // only the timers that are actually due get looked at
+    while (!timerQueue.empty() && timerQueue.top().when <= currTime) {
+        ScheduledTimer timer = timerQueue.top();
+        timerQueue.pop();
+
+        if (timer.event == nullptr) {
+            auto it = oneShotTimers.find(timer.id);
+            if (it == oneShotTimers.end())
+                continue; // cancelled
+
+            OneShotHandler handler = std::move(it->second);
+            oneShotTimers.erase(it);
+            handler(currTime);
+            continue;
         }
+
+        TimerEvent& event = *timer.event;
+        runTimer(event, timer.when, currTime);
+
+        // a zero interval would keep this loop from ever finishing
+        event.scheduledEvent = currTime + std::max(event.delta, (time_t)1);
+        timerQueue.push({event.scheduledEvent, nextTimerId++, &event});
     }
 }
+
+// sleep until the next timer is due, unless a packet comes in first
+int CNShardServer::waitTimeout() {
+    if (timerQueue.empty())
+        return 50;
+
+    time_t wait = timerQueue.top().when - getTime();
+    return (int)std::max((time_t)0, std::min(wait, (time_t)1000));
+}
@@ -2,32 +2,64 @@
 
 #include "core/Core.hpp"
 
-#include <map>
+#include <array>
 #include <list>
+#include <queue>
+#include <functional>
 
-#define REGISTER_SHARD_PACKET(pactype, handlr) CNShardServer::ShardPackets[pactype] = handlr;
-#define REGISTER_SHARD_TIMER(handlr, delta) CNShardServer::Timers.push_back(TimerEvent(handlr, delta));
+#define REGISTER_SHARD_PACKET(pactype, handlr) \
+    static_assert(Packets::index(pactype) >= 0, #pactype " has no packet table slot"); \
+    CNShardServer::ShardPackets[Packets::index(pactype)] = handlr;
+#define REGISTER_SHARD_TIMER(handlr, delta) CNShardServer::Timers.push_back(TimerEvent(handlr, delta, #handlr));
 #define MS_PER_PLAYER_TICK 500
 #define MS_PER_COMBAT_TICK 200
 
+typedef std::function<void(time_t)> OneShotHandler;
+
+// an entry in the timer heap; event is nullptr for one-shot timers
+struct ScheduledTimer {
+    time_t when;
+    uint64_t id;
+    TimerEvent *event;
+
+    // inverted, so the priority_queue is a min-heap (ties go in FIFO order)
+    bool operator<(const ScheduledTimer& other) const {
+        return when > other.when || (when == other.when && id > other.id);
+    }
+};
+
 class CNShardServer : public CNServer {
 private:
+    static std::priority_queue<ScheduledTimer> timerQueue;
+    static std::unordered_map<uint64_t, OneShotHandler> oneShotTimers;
+    static uint64_t nextTimerId;
+    static size_t scheduledTimers; // how many of Timers are in the heap
+
     static void handlePacket(CNSocket* sock, CNPacketData* data);
+    void runTimer(TimerEvent& event, time_t scheduled, time_t currTime);
 
     static void keepAliveTimer(CNServer*, time_t);
     static void periodicSaveTimer(CNServer* serv, time_t currTime);
 
 public:
-    static std::map<uint32_t, PacketHandler> ShardPackets;
+    static std::array<PacketHandler, Packets::TABLE_SIZE> ShardPackets; // indexed by Packets::index()
     static std::list<TimerEvent> Timers;
 
     CNShardServer(uint16_t p);
 
+    /*
+     * Calls handler once, delay ms from now. Per-entity timers just capture
+     * the entity's ID. Returns an ID that can be passed to cancelTimer().
+     */
+    static uint64_t scheduleOnce(time_t delay, OneShotHandler handler);
+    static void cancelTimer(uint64_t id);
+
     static void _killConnection(CNSocket *cns);
 
-    bool checkExtraSockets(int i);
+    bool checkExtraSockets(SOCKET fd, int revents);
     void newConnection(CNSocket* cns);
     void killConnection(CNSocket* cns);
     void kill();
     void onStep();
+    int waitTimeout();
 };
@@ -9,11 +9,18 @@
 // defaults :)
 int settings::VERBOSITY = 1;
 bool settings::SANDBOX = true;
+#ifdef __linux__
+std::string settings::EVENTBACKEND = "epoll";
+#else
+std::string settings::EVENTBACKEND = "poll";
+#endif
+int settings::PACKETSPERTICK = 32;
 
 int settings::LOGINPORT = 23000;
 bool settings::APPROVEALLNAMES = true;
 bool settings::AUTOCREATEACCOUNTS = true;
 int settings::DBSAVEINTERVAL = 240;
+int settings::PASSWORDTHREADS = 2;
 
 int settings::SHARDPORT = 23001;
 std::string settings::SHARDSERVERIP = "127.0.0.1";
@@ -21,6 +28,12 @@ bool settings::LOCALHOSTWORKAROUND = true;
 time_t settings::TIMEOUT = 60000;
 int settings::VIEWDISTANCE = 25600;
 bool settings::SIMULATEMOBS = true;
+// extra threads used to plan mob aggro each tick; 0 keeps it all on the shard thread
+int settings::AITHREADS = 0;
+// coalesce and thin out player movement updates; see PlayerMovement.cpp
+bool settings::DEADRECKONING = false;
+// fixed seed for the gameplay RNG, so that drops and mob behaviour can be replayed; 0 picks a new one
+uint64_t settings::RANDSEED = 0;
 bool settings::ANTICHEAT = true;
 
 // default spawn point
@@ -38,6 +51,11 @@ int settings::SPAWN_Z = 8450;
 int settings::SPAWN_ANGLE = 130;
 
 std::string settings::DBPATH = "database.db";
+std::string settings::DBJOURNAL = "wal";
+std::string settings::DBSYNC = "normal";
+int settings::DBCACHESIZE = 8192; // KiB
+int settings::DBMMAPSIZE = 64; // MiB
+int settings::DBPAGESIZE = 4096;
 std::string settings::TDATADIR = "tdata/";
 std::string settings::PATCHDIR = "tdata/patch/";
 
@@ -84,16 +102,22 @@ void settings::init() {
 
     VERBOSITY = reader.GetInteger("", "verbosity", VERBOSITY);
     SANDBOX = reader.GetBoolean("", "sandbox", SANDBOX);
+    EVENTBACKEND = reader.Get("", "eventbackend", EVENTBACKEND);
+    PACKETSPERTICK = reader.GetInteger("", "packetspertick", PACKETSPERTICK);
     LOGINPORT = reader.GetInteger("login", "port", LOGINPORT);
     APPROVEALLNAMES = reader.GetBoolean("login", "acceptallcustomnames", APPROVEALLNAMES);
     AUTOCREATEACCOUNTS = reader.GetBoolean("login", "autocreateaccounts", AUTOCREATEACCOUNTS);
     DBSAVEINTERVAL = reader.GetInteger("login", "dbsaveinterval", DBSAVEINTERVAL);
+    PASSWORDTHREADS = reader.GetInteger("login", "passwordthreads", PASSWORDTHREADS);
     SHARDPORT = reader.GetInteger("shard", "port", SHARDPORT);
     SHARDSERVERIP = reader.Get("shard", "ip", SHARDSERVERIP);
     LOCALHOSTWORKAROUND = reader.GetBoolean("shard", "localhostworkaround", LOCALHOSTWORKAROUND);
     TIMEOUT = reader.GetInteger("shard", "timeout", TIMEOUT);
     VIEWDISTANCE = reader.GetInteger("shard", "viewdistance", VIEWDISTANCE);
     SIMULATEMOBS = reader.GetBoolean("shard", "simulatemobs", SIMULATEMOBS);
+    AITHREADS = reader.GetInteger("shard", "aithreads", AITHREADS);
+    DEADRECKONING = reader.GetBoolean("shard", "deadreckoning", DEADRECKONING);
+    RANDSEED = reader.GetInteger("shard", "randseed", RANDSEED);
     SPAWN_X = reader.GetInteger("shard", "spawnx", SPAWN_X);
     SPAWN_Y = reader.GetInteger("shard", "spawny", SPAWN_Y);
     SPAWN_Z = reader.GetInteger("shard", "spawnz", SPAWN_Z);
@@ -107,6 +131,11 @@ void settings::init() {
     GRUNTWORKJSON = reader.Get("shard", "gruntwork", GRUNTWORKJSON);
     MOTDSTRING = reader.Get("shard", "motd", MOTDSTRING);
     DBPATH = reader.Get("shard", "dbpath", DBPATH);
+    DBJOURNAL = reader.Get("shard", "dbjournal", DBJOURNAL);
+    DBSYNC = reader.Get("shard", "dbsync", DBSYNC);
+    DBCACHESIZE = reader.GetInteger("shard", "dbcachesize", DBCACHESIZE);
+    DBMMAPSIZE = reader.GetInteger("shard", "dbmmapsize", DBMMAPSIZE);
+    DBPAGESIZE = reader.GetInteger("shard", "dbpagesize", DBPAGESIZE);
     TDATADIR = reader.Get("shard", "tdatadir", TDATADIR);
     PATCHDIR = reader.Get("shard", "patchdir", PATCHDIR);
     ENABLEDPATCHES = reader.Get("shard", "enabledpatches", ENABLEDPATCHES);
@@ -5,10 +5,13 @@
 namespace settings {
     extern int VERBOSITY;
     extern bool SANDBOX;
+    extern std::string EVENTBACKEND;
+    extern int PACKETSPERTICK;
     extern int LOGINPORT;
     extern bool APPROVEALLNAMES;
     extern bool AUTOCREATEACCOUNTS;
     extern int DBSAVEINTERVAL;
+    extern int PASSWORDTHREADS;
     extern int SHARDPORT;
     extern std::string SHARDSERVERIP;
     extern bool LOCALHOSTWORKAROUND;
@@ -16,6 +19,9 @@ namespace settings {
     extern time_t TIMEOUT;
     extern int VIEWDISTANCE;
     extern bool SIMULATEMOBS;
+    extern int AITHREADS;
+    extern bool DEADRECKONING;
+    extern uint64_t RANDSEED;
     extern int SPAWN_X;
     extern int SPAWN_Y;
     extern int SPAWN_Z;
@@ -30,6 +36,11 @@ namespace settings {
     extern std::string EGGSJSON;
     extern std::string GRUNTWORKJSON;
     extern std::string DBPATH;
+    extern std::string DBJOURNAL;
+    extern std::string DBSYNC;
+    extern int DBCACHESIZE;
+    extern int DBMMAPSIZE;
+    extern int DBPAGESIZE;
     extern std::string PATCHDIR;
     extern std::string ENABLEDPATCHES;
     extern std::string TDATADIR;